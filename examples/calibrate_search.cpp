@@ -0,0 +1,58 @@
+// Measures the linear/binary node search crossover of a few key types on
+// this machine, and prints a header with the matching WTreeSearchThreshold
+// specializations. Include that header before the containers to use them:
+//
+//   ./calibrate_search > wtree_thresholds.hpp
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+#include "../include/wtree/map.hpp"
+#include "../include/wtree/optional/calibrate.hpp"
+#include "../include/wtree/set.hpp"
+
+using namespace std;
+using namespace WTreeLib;
+
+// A 16-byte composite key.
+struct PairKey {
+  uint64_t hi, lo;
+  bool operator<(const PairKey &o) const {
+    return hi < o.hi || (hi == o.hi && lo < o.lo);
+  }
+};
+
+template <typename Container, typename Generator>
+void calibrate(const char *key_name, const char *compare_name,
+               Generator gen) {
+  const auto samples = WTreeCalibration::measure<Container>(gen, 1024);
+  fprintf(stderr, "%s:\n", key_name);
+  for (const auto &s : samples)
+    fprintf(stderr, "  %5u keys: linear %7.1f ns, binary %7.1f ns\n", s.keys,
+            s.linear_ns, s.binary_ns);
+  WTreeCalibration::emit_threshold_specialization(
+      stdout, key_name, compare_name, WTreeCalibration::crossover(samples));
+}
+
+int main() {
+  mt19937_64 rng(42);
+  printf("// Generated by calibrate_search.\n"
+         "#pragma once\n"
+         "#include <cstdint>\n"
+         "#include <string>\n"
+         "#include \"wtree/detail/traits.hpp\"\n");
+
+  calibrate<WTreeLib::set<int, 16384>>(
+      "int", "std::less<int>", [&](uint) { return static_cast<int>(rng()); });
+  calibrate<WTreeLib::set<uint64_t, 16384>>(
+      "uint64_t", "std::less<uint64_t>", [&](uint) { return rng(); });
+  calibrate<WTreeLib::set<PairKey, 32768>>(
+      "PairKey", "std::less<PairKey>",
+      [&](uint) { return PairKey{rng() % 16, rng()}; });
+  calibrate<WTreeLib::map<string, int, 65536>>(
+      "std::string", "std::less<std::string>",
+      [&](uint) { return "key/" + to_string(rng() % 100000000); });
+  return 0;
+}
@@ -2,6 +2,7 @@
 #define _WTREE_CONTAINERS__H_
 
 #include "index.hpp"
+#include "value_box.hpp"
 
 #include <utility>
 
@@ -13,17 +14,23 @@ namespace WTreeLib {
  */
 template <typename Key, typename Compare, typename Alloc,
           int TargetNodeBytes = WTREE_TARGET_NODE_BYTES,
-          typename ValueType = Key, bool HoldsUnique = true>
+          typename ValueType = Key, bool HoldsUnique = true,
+          typename SearchPolicy = WTreeSearchPolicy<>>
 struct WTreeCommonParams {
 public:
   // Whether this container enforces unique keys (set/map) or allows
   // duplicates (multiset/multimap).
   static constexpr bool kUnique = HoldsUnique;
   // If Compare is derived from wtree_key_compare_to_tag then use it as the
-  // key_compare type. Otherwise, use wtree_key_compare_to_adapter<> which
-  // will fall-back to Compare if we don't have an appropriate specialization.
-  typedef std::conditional_t<WTreeIsKeyCompareTo<Compare>::value, Compare,
-                             WTreeKeyCompareToAdapter<Compare>>
+  // key_compare type. Keys ordered through their operator<=> use
+  // wtree_three_way_compare_adapter<>. Otherwise, use
+  // wtree_key_compare_to_adapter<> which will fall-back to Compare if we
+  // don't have an appropriate specialization.
+  typedef std::conditional_t<
+      WTreeIsKeyCompareTo<Compare>::value, Compare,
+      std::conditional_t<WTreeIsThreeWayCompare<Key, Compare>::value,
+                         WTreeThreeWayCompareAdapter<Key, Compare>,
+                         WTreeKeyCompareToAdapter<Compare>>>
       key_compare;
   // A type which indicates if we have a key-compare-to functor or a plain old
   // key-compare functor.
@@ -48,29 +55,92 @@ public:
   using internal_allocator_traits =
       std::allocator_traits<internal_allocator_type>;
 
-  using size_helper = WTreeSizeHelper<key_type, TargetNodeBytes, value_type>;
+  // Whether map nodes hold handles to values allocated out of line, see
+  // WTREE_MAP_OUT_OF_LINE_BYTES.
+  static constexpr bool kUseOutOfLineValues =
+      !std::is_same_v<value_type, key_type> &&
+      std::is_trivially_copyable_v<key_type> &&
+      WTreeStoreOutOfLine<value_type>::value;
+
+  // What node slots hold: the values, or handles to them.
+  using slot_type =
+      std::conditional_t<kUseOutOfLineValues,
+                         WTreeValueBox<value_type, Alloc>, value_type>;
+
+  static reference element(slot_type &slot) {
+    if constexpr (kUseOutOfLineValues)
+      return *slot;
+    else
+      return slot;
+  }
+  static const_reference element(const slot_type &slot) {
+    if constexpr (kUseOutOfLineValues)
+      return *slot;
+    else
+      return slot;
+  }
 
+  // Whether map nodes keep their keys in a separate keys-only array too,
+  // see WTREE_MAP_KEY_COLUMN. Out-of-line values always do, so that
+  // searches never follow the handles.
+  static constexpr bool kUseKeyColumn =
+      (WTREE_MAP_KEY_COLUMN || kUseOutOfLineValues) &&
+      !std::is_same_v<value_type, key_type> &&
+      std::is_trivially_copyable_v<key_type>;
+
+  // Nodes get their k (and the types and limits that follow from it) from
+  // WTreeNodeSizing over the final params type, so that params deriving
+  // from these and turning on per-slot arrays are sized for them.
   static constexpr uint kTargetNodeBytes = TargetNodeBytes;
-  static constexpr uint kTargetK =
-      size_helper::determine_optimal_k(kTargetNodeBytes);
-  static constexpr uint kLastGrowth =
-      size_helper::determine_last_growth_limit(kTargetK);
-
-  typedef typename std::conditional <
-      kTargetK<255, uint8_t, uint16_t>::type field_type;
 
   // Binary search thresholds based on key type complexity.
   static constexpr bool is_numeric_key =
       std::is_integral<key_type>::value ||
       std::is_floating_point<key_type>::value;
   static constexpr uint kBinarySearchThreshold =
-      is_numeric_key ? WTREE_BINARY_SEARCH_THRESHOLD_NUMERIC
-                     : WTREE_BINARY_SEARCH_THRESHOLD_COMPLEX;
-
-  // Whether binary search should be used for full internal nodes.
-  // Internal nodes are always full with kTargetK elements.
-  static constexpr bool kUseBinarySearchForInternal =
-      kTargetK >= kBinarySearchThreshold;
+      WTreeSearchThreshold<key_type, Compare>::value;
+  // Whether nodes read the threshold at runtime from calibrated_threshold.
+  static constexpr bool kUseCalibratedThreshold =
+      WTREE_CALIBRATED_SEARCH_THRESHOLD;
+  // Whether node slabs come from huge-page regions, see
+  // WTREE_NODE_HUGE_PAGES.
+  static constexpr bool kUseHugePages = WTREE_NODE_HUGE_PAGES;
+  // Whether internal nodes hold child handles instead of pointers, see
+  // WTREE_NODE_CHILD_HANDLES.
+  static constexpr bool kUseChildHandles = WTREE_NODE_CHILD_HANDLES;
+  using calibrated_threshold = WTreeCalibratedThreshold<key_type, Compare>;
+
+  // Search methods of internal nodes and leaves, see WTreeSearchPolicy.
+  using search_policy = SearchPolicy;
+  static constexpr WTreeSearchMethod kInternalSearchMethod =
+      SearchPolicy::kInternalMethod;
+  static constexpr WTreeSearchMethod kLeafSearchMethod =
+      SearchPolicy::kLeafMethod;
+
+  // Whether binary searches use the branch-free variant.
+  static constexpr bool kUseBranchlessSearch =
+      WTREE_BRANCHLESS_BINARY_SEARCH && is_numeric_key;
+
+  // Fence index stride, see WTREE_NODE_FENCE_STRIDE. Nodes of less than
+  // 4 * kFenceStride keys go without.
+  static constexpr uint kFenceStride = WTREE_NODE_FENCE_STRIDE;
+  static constexpr bool kUseFences =
+      kFenceStride > 0 && std::is_trivially_copyable_v<key_type>;
+
+  // Whether nodes keep the abbreviated (8-byte prefix) keys of their values.
+  static constexpr bool kUseKeyPrefixes =
+      WTREE_STRING_KEY_PREFIXES && WTreeKeyPrefix<key_type>::kSupported &&
+      WTreeSimdCompareOrder<key_type, key_compare>::value ==
+          WTreeSimdOrder::kLess;
+
+  // Whether full internal nodes also keep their keys in Eytzinger order.
+  static constexpr bool kUseEytzingerLayout =
+      WTREE_EYTZINGER_INTERNAL_NODES && std::is_trivially_copyable_v<key_type>;
+
+  // Whether nodes keep a learned position model, see WTREE_LEARNED_NODE_MODEL.
+  // Nodes of less than 64 keys go without.
+  static constexpr bool kUseLearnedModel =
+      WTREE_LEARNED_NODE_MODEL && is_numeric_key;
 };
 
 /**
@@ -110,6 +180,9 @@ public:
                  const allocator_type &alloc = allocator_type())
       : m_tree(comp, alloc) {}
 
+  explicit WTreeContainer(const allocator_type &alloc)
+      : m_tree(key_compare(), alloc) {}
+
   // Copy/move/assign — compiler-generated versions forward correctly.
   WTreeContainer(const WTreeContainer &) = default;
   WTreeContainer(WTreeContainer &&) noexcept = default;
@@ -121,6 +194,10 @@ public:
   //  */
   Tree *tree() noexcept { return &m_tree; };
   void clear() noexcept { m_tree.clear(); }
+  // Frees the room erases left in the nodes and lays them out depth-first,
+  // e.g. after a bulk load or heavy churn. This is also what gives back the
+  // node slabs that erases emptied. Invalidates iterators.
+  void shrink_to_fit() { m_tree.shrink_to_fit(); }
 
   void swap(WTreeContainer &other) noexcept { m_tree.swap(other.m_tree); }
 
@@ -150,14 +227,14 @@ public:
 
   // === Lookup routines (shared for unique and multi) ===
 
-  // bool contains(const key_type &key) const { return find(key) != cend(); }
+  bool contains(const key_type &key) const { return m_tree.contains(key); }
 
   iterator lower_bound(const key_type &key) {
     iterator iter(m_tree.root(), 0);
     return m_tree.lower_bound(key, iter).first;
   }
   const_iterator lower_bound(const key_type &key) const {
-    const_iterator iter(m_tree.root(), 0);
+    const_iterator iter(m_tree.croot(), 0);
     return m_tree.lower_bound(key, iter).first;
   }
 
@@ -166,7 +243,7 @@ public:
     return m_tree.upper_bound(key, iter).first;
   }
   const_iterator upper_bound(const key_type &key) const {
-    const_iterator iter(m_tree.root(), 0);
+    const_iterator iter(m_tree.croot(), 0);
     return m_tree.upper_bound(key, iter).first;
   }
 
@@ -178,6 +255,36 @@ public:
     return {lower_bound(key), upper_bound(key)};
   }
 
+  // === Block scans (shared) ===
+
+  using block_type = typename Tree::block_type;
+
+  // Calls fn with every value in order, in spans of values stored next to
+  // each other in a node (see WTree::for_each_block); fn may return false
+  // to stop.
+  template <typename Fn> void for_each_block(Fn &&fn) const {
+    m_tree.for_each_block(fn);
+  }
+  // The same for the values with keys in [lo, hi).
+  template <typename Fn>
+  void for_each_block(const key_type &lo, const key_type &hi, Fn &&fn) const {
+    m_tree.for_each_block(lo, hi, fn);
+  }
+  // The same from the last value to the first, the values of a block still
+  // in ascending order; all of them, those below hi, or those in [lo, hi).
+  template <typename Fn> void for_each_block_reverse(Fn &&fn) const {
+    m_tree.for_each_block_reverse(fn);
+  }
+  template <typename Fn>
+  void for_each_block_reverse(const key_type &hi, Fn &&fn) const {
+    m_tree.for_each_block_reverse(hi, fn);
+  }
+  template <typename Fn>
+  void for_each_block_reverse(const key_type &lo, const key_type &hi,
+                              Fn &&fn) const {
+    m_tree.for_each_block_reverse(lo, hi, fn);
+  }
+
   // === Deletion routines (shared) ===
 
   iterator erase(iterator iter) noexcept { return m_tree.erase(iter); }
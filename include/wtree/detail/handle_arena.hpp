@@ -0,0 +1,184 @@
+#ifndef _WTREE_HANDLE_ARENA__H_
+#define _WTREE_HANDLE_ARENA__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define WTREE_HAS_MMAP 1
+#else
+#define WTREE_HAS_MMAP 0
+#endif
+
+namespace WTreeLib {
+
+/**
+ * The span of address space all child-handle trees carve their node slabs
+ * from (see WTREE_NODE_CHILD_HANDLES), so that internal nodes can refer to
+ * their children by 32-bit handles instead of pointers.
+ *
+ * The span holds 2^32 handles of kAlign bytes (64 GiB) and is aligned to
+ * its size: a node finds the span from its own address, and a handle is
+ * the offset of a node in the span over kAlign, 0 being no node. It is
+ * reserved once per process, on first use, without access: it takes
+ * address space but neither memory nor commit charge, and chunks are only
+ * made accessible as they are carved.
+ *
+ * Blocks are whole numbers of kChunkBytes chunks, carved from the span
+ * and kept on a free list per chunk count once freed; freed blocks give
+ * their memory back to the OS. The span is shared by the trees of all
+ * threads and guarded by a mutex, seldom taken as slabs are large. It is
+ * never unmapped, as trees may outlive static destruction. Running out of
+ * span throws std::bad_alloc.
+ */
+class WTreeHandleSpan {
+public:
+  using handle_type = uint32_t;
+
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+  static constexpr size_t kSpanBytes = (size_t(1) << 32) * kAlign;
+  static constexpr size_t kChunkBytes = size_t(64) << 10;
+
+  // The handle of node, which lives in the span.
+  static handle_type encode(const void *node) {
+    return static_cast<handle_type>(reinterpret_cast<uintptr_t>(node) %
+                                    kSpanBytes / kAlign);
+  }
+  // The node handle refers to, in the span of from (any node in it).
+  static void *decode(const void *from, handle_type handle) {
+    if (handle == 0)
+      return nullptr;
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(from) /
+                                        kSpanBytes * kSpanBytes +
+                                    uintptr_t(handle) * kAlign);
+  }
+
+  static WTreeHandleSpan &instance() {
+    // Leaked on purpose, see above.
+    static WTreeHandleSpan *span = new WTreeHandleSpan();
+    return *span;
+  }
+
+  static size_t block_bytes(size_t bytes) {
+    return (bytes + kChunkBytes - 1) / kChunkBytes * kChunkBytes;
+  }
+
+  // An accessible block of block_bytes(bytes), aligned to kChunkBytes.
+  void *allocate(size_t bytes, bool huge_pages) {
+    const size_t chunks = block_bytes(bytes) / kChunkBytes;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (chunks < m_free.size() && !m_free[chunks].empty()) {
+      char *block = m_free[chunks].back();
+      m_free[chunks].pop_back();
+      return block;
+    }
+    if (m_span == nullptr)
+      reserve();
+    if (static_cast<size_t>(m_span + kSpanBytes - m_cursor) <
+        chunks * kChunkBytes)
+      throw std::bad_alloc();
+    char *block = m_cursor;
+#if WTREE_HAS_MMAP
+    if (mprotect(block, chunks * kChunkBytes, PROT_READ | PROT_WRITE) != 0)
+      throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+    if (huge_pages)
+      madvise(block, chunks * kChunkBytes, MADV_HUGEPAGE);
+#endif
+#endif
+    (void)huge_pages;
+    m_cursor += chunks * kChunkBytes;
+    return block;
+  }
+
+  void deallocate(void *block, size_t bytes) {
+    const size_t chunks = block_bytes(bytes) / kChunkBytes;
+#if WTREE_HAS_MMAP && defined(MADV_DONTNEED)
+    madvise(block, chunks * kChunkBytes, MADV_DONTNEED);
+#endif
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (chunks >= m_free.size())
+      m_free.resize(chunks + 1);
+    m_free[chunks].push_back(static_cast<char *>(block));
+  }
+
+  // Bytes of span carved so far, including freed blocks.
+  size_t carved_bytes() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_span == nullptr ? 0 : m_cursor - m_span;
+  }
+
+private:
+  WTreeHandleSpan() = default;
+
+  void reserve() {
+#if WTREE_HAS_MMAP
+    // Map twice the size and trim it to an aligned span.
+    void *raw = mmap(nullptr, 2 * kSpanBytes, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+      throw std::bad_alloc();
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned =
+        (begin + kSpanBytes - 1) / kSpanBytes * kSpanBytes;
+    if (aligned > begin)
+      munmap(raw, aligned - begin);
+    munmap(reinterpret_cast<void *>(aligned + kSpanBytes),
+           begin + kSpanBytes - aligned);
+    m_span = reinterpret_cast<char *>(aligned);
+    // Handle 0 is no node: skip the first chunk.
+    m_cursor = m_span + kChunkBytes;
+#else
+    throw std::bad_alloc();
+#endif
+  }
+
+  std::mutex m_mutex;
+  char *m_span = nullptr;
+  char *m_cursor = nullptr; // Start of the never used part of the span.
+  std::vector<std::vector<char *>> m_free; // Freed blocks, by chunk count.
+};
+
+/**
+ * Source of the node slabs of one tree, carved from the shared
+ * WTreeHandleSpan. It only counts the bytes it holds, so that moving or
+ * swapping trees moves nothing. With HugePages, its blocks are advised
+ * for transparent huge pages.
+ */
+template <bool HugePages = false> class WTreeHandleArena {
+public:
+  WTreeHandleArena() = default;
+  WTreeHandleArena(WTreeHandleArena &&other) noexcept
+      : m_bytes(std::exchange(other.m_bytes, 0)) {}
+  WTreeHandleArena(const WTreeHandleArena &) = delete;
+  WTreeHandleArena &operator=(const WTreeHandleArena &) = delete;
+
+  void *allocate(size_t bytes) {
+    void *block = WTreeHandleSpan::instance().allocate(bytes, HugePages);
+    m_bytes += WTreeHandleSpan::block_bytes(bytes);
+    return block;
+  }
+
+  void deallocate(void *block, size_t bytes) {
+    WTreeHandleSpan::instance().deallocate(block, bytes);
+    m_bytes -= WTreeHandleSpan::block_bytes(bytes);
+  }
+
+  // Bytes of span the tree holds.
+  size_t bytes() const { return m_bytes; }
+
+  void swap(WTreeHandleArena &other) noexcept {
+    std::swap(m_bytes, other.m_bytes);
+  }
+
+private:
+  size_t m_bytes = 0;
+};
+
+} // namespace WTreeLib
+#endif
@@ -0,0 +1,146 @@
+#ifndef _WTREE_HUGE_PAGE_ARENA__H_
+#define _WTREE_HUGE_PAGE_ARENA__H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>
+#define WTREE_HAS_MMAP 1
+#else
+#define WTREE_HAS_MMAP 0
+#endif
+
+namespace WTreeLib {
+
+/**
+ * Source of node slabs backed by 2 MiB regions mapped straight from the OS
+ * (see WTREE_NODE_HUGE_PAGES), so that the nodes a descent visits share a
+ * few TLB entries.
+ *
+ * Regions come from hugetlbfs when huge pages are reserved, and otherwise
+ * from anonymous memory aligned to 2 MiB and advised for transparent huge
+ * pages. Blocks are carved out of the last region; each region counts its
+ * live blocks and is unmapped when the last one is freed. allocate()
+ * returns nullptr when no region can be mapped, and callers fall back to
+ * their allocator.
+ */
+class WTreeHugePageArena {
+  struct region_header {
+    char *cursor;  // Start of the unused part of the region.
+    size_t blocks; // Live blocks.
+  };
+
+public:
+  static constexpr size_t kRegionBytes = size_t(2) << 20;
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+  static constexpr size_t kHeaderBytes =
+      (sizeof(region_header) + kAlign - 1) / kAlign * kAlign;
+  // Largest block a region can hold.
+  static constexpr size_t kMaxBlockBytes = kRegionBytes - kHeaderBytes;
+
+  WTreeHugePageArena() = default;
+  WTreeHugePageArena(WTreeHugePageArena &&other) noexcept
+      : m_region(std::exchange(other.m_region, nullptr)),
+        m_regions(std::exchange(other.m_regions, 0)) {}
+  WTreeHugePageArena(const WTreeHugePageArena &) = delete;
+  WTreeHugePageArena &operator=(const WTreeHugePageArena &) = delete;
+
+  // Regions are unmapped as their blocks are freed; the last one may be
+  // empty and still mapped.
+  ~WTreeHugePageArena() {
+    if (m_region != nullptr && m_region->blocks == 0)
+      unmap(m_region);
+  }
+
+  // A block of bytes (a multiple of kAlign, at most kMaxBlockBytes).
+  void *allocate(size_t bytes) {
+    if (m_region == nullptr ||
+        reinterpret_cast<char *>(m_region) + kRegionBytes - m_region->cursor <
+            static_cast<ptrdiff_t>(bytes)) {
+      if (m_region != nullptr && m_region->blocks == 0)
+        unmap(m_region);
+      m_region = map_region();
+      if (m_region == nullptr)
+        return nullptr;
+    }
+    void *block = m_region->cursor;
+    m_region->cursor += bytes;
+    ++m_region->blocks;
+    return block;
+  }
+
+  void deallocate(void *block) {
+    region_header *region = region_of(block);
+    if (--region->blocks == 0 && region != m_region)
+      unmap(region);
+  }
+
+  // Regions currently mapped.
+  size_t regions() const { return m_regions; }
+
+  void swap(WTreeHugePageArena &other) noexcept {
+    std::swap(m_region, other.m_region);
+    std::swap(m_regions, other.m_regions);
+  }
+
+private:
+  static region_header *region_of(const void *block) {
+    return reinterpret_cast<region_header *>(
+        reinterpret_cast<uintptr_t>(block) / kRegionBytes * kRegionBytes);
+  }
+
+  region_header *map_region() {
+#if WTREE_HAS_MMAP
+    void *raw = MAP_FAILED;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_2MB)
+    // Explicit huge pages, only there when the system reserved some.
+    raw = mmap(nullptr, kRegionBytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1,
+               0);
+#endif
+    if (raw == MAP_FAILED) {
+      // Map twice the size and trim it to an aligned region, so that the
+      // kernel can back it with transparent huge pages.
+      raw = mmap(nullptr, 2 * kRegionBytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (raw == MAP_FAILED)
+        return nullptr;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+      const uintptr_t aligned =
+          (begin + kRegionBytes - 1) / kRegionBytes * kRegionBytes;
+      if (aligned > begin)
+        munmap(raw, aligned - begin);
+      if (aligned + kRegionBytes < begin + 2 * kRegionBytes)
+        munmap(reinterpret_cast<void *>(aligned + kRegionBytes),
+               begin + kRegionBytes - aligned);
+      raw = reinterpret_cast<void *>(aligned);
+#if defined(MADV_HUGEPAGE)
+      madvise(raw, kRegionBytes, MADV_HUGEPAGE);
+#endif
+    }
+    ++m_regions;
+    char *base = static_cast<char *>(raw);
+    return new (base) region_header{base + kHeaderBytes, 0};
+#else
+    return nullptr;
+#endif
+  }
+
+  void unmap(region_header *region) {
+#if WTREE_HAS_MMAP
+    if (region == m_region)
+      m_region = nullptr;
+    --m_regions;
+    munmap(region, kRegionBytes);
+#endif
+  }
+
+  region_header *m_region = nullptr; // Region blocks are carved from.
+  size_t m_regions = 0;
+};
+
+} // namespace WTreeLib
+#endif
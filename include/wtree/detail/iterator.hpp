@@ -2,6 +2,7 @@
 #define _WTREE_ITERATOR__H_
 
 #include "node.hpp"
+#include "path_stack.hpp"
 #include "traits.hpp"
 
 #include <cassert>
@@ -41,20 +42,23 @@ public:
   typedef WTreeIterator<Node, Reference, Pointer> self_type;
 
   static_assert(
-      std::numeric_limits<int>::max() >= params_type::kTargetK,
+      std::numeric_limits<int>::max() >= Node::kTargetK,
       "Index has no enought size for the last valid node's values index.");
 
   // The node in the tree the iterator is pointing at.
   normal_node *node;
   // The index within the node of the tree the iterator is pointing at.
   int index;
-  // Vectors for ascendant path in search and remove routines.
-  std::vector<normal_node *> ascendants;
-  std::vector<field_type> move_indexes;
+  // Stacks for ascendant path in search and remove routines, inline up to
+  // kInlinePathDepth levels.
+  static constexpr size_t kInlinePathDepth = WTREE_ITERATOR_PATH_DEPTH;
+  WTreePathStack<normal_node *, kInlinePathDepth> ascendants;
+  WTreePathStack<field_type, kInlinePathDepth> move_indexes;
 
   template <typename> friend class WTree;
   template <typename> friend class WTreeNodeManager;
   template <typename> friend class WTreeNodeLocator;
+  template <typename, typename, typename> friend class WTreeReverseIterator;
   friend iterator;
   friend const_iterator;
 
@@ -3,6 +3,7 @@
 
 #include "iterator.hpp"
 
+#include <algorithm>
 #include <cassert>
 
 namespace WTreeLib {
@@ -19,10 +20,10 @@ void WTreeIterator<Node, Reference, Pointer>::increment() {
   }
 
   if (node->is_leaf()) {
-    assert(has_ascendant());
     assert(c > 0);
 
-    if (index == c - 1) {
+    // A root leaf (of a small tree) ends at its size.
+    if (index == c - 1 && has_ascendant()) {
       ascend();
     }
     ++index;
@@ -46,10 +47,9 @@ template <typename Node, typename Reference, typename Pointer>
 void WTreeIterator<Node, Reference, Pointer>::increment_by(size_t count) {
   while (count > 0) {
     if (node->is_leaf()) {
-      // A leaf always has an ascendant,
-      // i.e. there is a succesor key.
+      // A leaf has an ascendant, i.e. there is a succesor key, unless it
+      // is the root of a small tree.
       assert(node->size() > 0);
-      assert(has_ascendant());
 
       // The rest inside the node is one less, but one is added
       // to include the successor in the move.
@@ -57,7 +57,7 @@ void WTreeIterator<Node, Reference, Pointer>::increment_by(size_t count) {
       size_t take = std::min(rest, count);
       count -= take;
       index += take;
-      if (index < node->size()) {
+      if (index < node->size() || !has_ascendant()) {
         return;
       }
       ascend();
@@ -147,14 +147,13 @@ template <typename Node, typename Reference, typename Pointer>
 void WTreeIterator<Node, Reference, Pointer>::decrement_by(size_t count) {
   while (count > 0) {
     if (node->is_leaf()) {
-      // A leaf always has an ascendant,
-      // i.e. there is a predeccesor key.
+      // A leaf has an ascendant, i.e. there is a predeccesor key, unless
+      // it is the root of a small tree.
       assert(node->size() > 0);
-      assert(has_ascendant());
 
-      if (count <= index) {
+      if (count <= index || !has_ascendant()) {
         // Here we never ascend from the leaf.
-        index -= count;
+        index -= std::min<size_t>(count, index);
         return;
       }
 
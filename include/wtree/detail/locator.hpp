@@ -57,6 +57,13 @@ public:
   template <typename IterType>
   int internal_locate_any(const key_type &key, IterType &iter) const;
 
+  /**
+   * @brief Membership test with the early-stop descent of
+   * internal_locate_any, walking node pointers only: no iterator and no
+   * path are kept.
+   */
+  bool internal_contains(const key_type &key, const node_type *node) const;
+
   template <typename IterType>
   int internal_locate_any_hint(const key_type &key, IterType &iter) const {
     internal_ascend_until_bound(key, iter);
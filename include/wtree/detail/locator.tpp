@@ -85,6 +85,50 @@ int WTreeLocator<Params>::internal_locate_any(const key_type &key,
     return 0;
 }
 
+template <typename Params>
+bool WTreeLocator<Params>::internal_contains(const key_type &key,
+                                             const node_type *node) const {
+  if (node->size() == 0)
+    return false;
+
+  for (;;) {
+    assert(node->size() > 0);
+
+    // Keys out of the node bounds are in no child of it.
+    int index;
+    if constexpr (is_key_compare_to::value) {
+      const int cmp_first = key_comp()(key, node->key(0));
+      if (cmp_first <= 0)
+        return cmp_first == 0;
+      const int cmp_last = key_comp()(node->key(node->size() - 1), key);
+      if (cmp_last <= 0)
+        return cmp_last == 0;
+
+      const int res = node->is_internal()
+                          ? node->bounded_lower_bound_internal(key, key_comp())
+                          : node->bounded_lower_bound_leaf(key, key_comp());
+      if (res & kExactMatch)
+        return true;
+      index = res & kMatchMask;
+    } else {
+      if (key_comp()(key, node->key(0)) ||
+          key_comp()(node->key(node->size() - 1), key))
+        return false;
+
+      index = node->is_internal()
+                  ? node->bounded_lower_bound_internal(key, key_comp())
+                  : node->bounded_lower_bound_leaf(key, key_comp());
+      if (!key_comp()(key, node->key(index)))
+        return true;
+    }
+
+    // Here key(index - 1) < key < key(index), with index > 0.
+    if (node->is_leaf() || node->child(index - 1) == nullptr)
+      return false;
+    node = node->child(index - 1);
+  }
+}
+
 template <typename Params>
 template <typename IterType>
 int WTreeLocator<Params>::internal_lower_bound_unique(const key_type &key,
@@ -1,8 +1,11 @@
 #ifndef _WTREE_NODE__H_
 #define _WTREE_NODE__H_
 
+#include "handle_arena.hpp"
+#include "simd_search.hpp"
 #include "traits.hpp"
 
+#include <bit>
 #include <cassert>
 #include <cstring>
 #include <sys/types.h>
@@ -17,12 +20,16 @@ template <typename Params> class WTreeNode {
 
 public:
   using params_type = Params;
-  using size_helper = Params::size_helper;
+  using sizing = WTreeNodeSizing<Params>;
+  using size_helper = typename sizing::size_helper;
 
   using key_type = typename params_type::key_type;
   using data_type = typename params_type::data_type;
   using value_type = typename params_type::value_type;
-  using field_type = typename params_type::field_type;
+  // What the values array holds: value_type, or a handle to an out-of-line
+  // value_type (see WTREE_MAP_OUT_OF_LINE_BYTES).
+  using slot_type = typename params_type::slot_type;
+  using field_type = typename sizing::field_type;
 
   using pointer = typename params_type::pointer;
   using const_pointer = typename params_type::const_pointer;
@@ -33,15 +40,120 @@ public:
   using difference_type = typename params_type::difference_type;
 
   static constexpr uint kTargetNodeBytes = params_type::kTargetNodeBytes;
-  static constexpr field_type kTargetK = params_type::kTargetK;
-  static constexpr field_type kLastGrowth = params_type::kLastGrowth;
+  static constexpr field_type kTargetK = sizing::kTargetK;
+  static constexpr field_type kLastGrowth = sizing::kLastGrowth;
 
   // Binary search threshold configuration from params.
   static constexpr bool is_numeric_key = params_type::is_numeric_key;
   static constexpr uint kBinarySearchThreshold =
       params_type::kBinarySearchThreshold;
   static constexpr bool kUseBinarySearchForInternal =
-      params_type::kUseBinarySearchForInternal;
+      sizing::kUseBinarySearchForInternal;
+  static constexpr bool kUseEytzingerLayout = params_type::kUseEytzingerLayout;
+  static constexpr bool kUseBranchlessSearch =
+      params_type::kUseBranchlessSearch;
+
+  static constexpr bool kUseCalibratedThreshold =
+      params_type::kUseCalibratedThreshold;
+
+  // Method that kAuto resolves to for nodes of at least
+  // binary_search_threshold() keys.
+  static constexpr WTreeSearchMethod kBinaryMethod =
+      kUseBranchlessSearch ? WTreeSearchMethod::kBranchless
+                           : WTreeSearchMethod::kBinary;
+  // Methods chosen by the container's search policy, or kAuto.
+  using search_policy = typename params_type::search_policy;
+  static constexpr WTreeSearchMethod kInternalSearchMethod =
+      params_type::kInternalSearchMethod;
+  static constexpr WTreeSearchMethod kLeafSearchMethod =
+      params_type::kLeafSearchMethod;
+  // Ranges at most this long are scanned after interpolating.
+  static constexpr int kInterpolationLinearRange = 16;
+
+  // Search copy of the keys of a full internal node, in Eytzinger (BFS)
+  // order: keys[1] is the root, keys[2i] and keys[2i+1] its children.
+  // Sorted values stay authoritative; this copy is rebuilt by
+  // refresh_search_layout once a write to the node is complete.
+  struct eytzinger_layout {
+    bool stale;
+    key_type keys[kTargetK + 1];
+  };
+  struct no_search_layout {};
+  using search_layout_type =
+      std::conditional_t<kUseEytzingerLayout, eytzinger_layout,
+                         no_search_layout>;
+
+  // Fence index: a stale flag followed by key(S-1), key(2S-1), ... where S
+  // is kFenceStride. Leaves store it right after their (partial) values
+  // array; internal nodes in internal_fields. See fenced_lower_bound_search.
+  static constexpr uint kFenceStride = params_type::kFenceStride;
+  static constexpr bool kUseFences =
+      params_type::kUseFences && kTargetK >= 4 * kFenceStride;
+  static constexpr uint kFenceKeysOffset = alignof(key_type);
+  static constexpr size_t kInternalFenceBytes =
+      kUseFences ? kFenceKeysOffset + (kTargetK / kFenceStride) *
+                                          sizeof(key_type)
+                 : 1;
+  struct fence_storage {
+    alignas(key_type) char bytes[kInternalFenceBytes];
+  };
+  using fence_storage_type =
+      std::conditional_t<kUseFences, fence_storage, no_search_layout>;
+
+  // Abbreviated keys: prefixes[i] is WTreeKeyPrefix of key(i), kept in step
+  // with the values by every value construct/swap/move routine. Leaves
+  // store them right after their values array (before the fences).
+  static constexpr bool kUseKeyPrefixes = params_type::kUseKeyPrefixes;
+  struct prefix_storage {
+    uint64_t prefixes[kTargetK];
+  };
+  using prefix_storage_type =
+      std::conditional_t<kUseKeyPrefixes, prefix_storage, no_search_layout>;
+
+  // Key column: keys[i] is a copy of the key of value i, kept in step with
+  // the values like the abbreviated keys; key() reads it. Every node stores
+  // it right after its values array, so that leaves and internal nodes
+  // find it at values + capacity().
+  static constexpr bool kUseKeyColumn = params_type::kUseKeyColumn;
+  static constexpr bool kUseOutOfLineValues = params_type::kUseOutOfLineValues;
+  static_assert(!kUseKeyColumn || std::is_trivially_copyable_v<key_type>,
+                "The key column is only kept for trivially copyable keys.");
+  struct key_column_storage {
+    key_type keys[kTargetK];
+  };
+  using key_column_type =
+      std::conditional_t<kUseKeyColumn, key_column_storage, no_search_layout>;
+
+  // Child handles: internal nodes refer to their children by their 32-bit
+  // handle in the shared node span (see WTREE_NODE_CHILD_HANDLES) instead
+  // of by pointer; child() and set_child() translate them.
+  static constexpr bool kUseChildHandles = params_type::kUseChildHandles;
+  using child_handle_type =
+      std::conditional_t<kUseChildHandles, WTreeHandleSpan::handle_type,
+                         self_type *>;
+
+  // Children bitmap: bit i of child_bits is set when child i exists, so
+  // that finding the nearest descendant scans words of the bitmap instead
+  // of the (mostly empty) child array.
+  static constexpr size_t kChildWords = (kTargetK - 1 + 63) / 64;
+
+  // Learned model: slot(k) ~= intercept + slope * k, off by at most
+  // max_error slots for the keys it was fit on. drift counts modifications
+  // since the fit; searches widen their window by it, and the write that
+  // takes it past kModelRefitDrift refits the model. Leaves store it after
+  // the fences.
+  static constexpr bool kUseLearnedModel =
+      params_type::kUseLearnedModel && kTargetK >= 64;
+  static constexpr int kModelMinKeys = 32;
+  static constexpr uint16_t kModelRefitDrift = 16;
+  struct node_model {
+    double slope;
+    double intercept;
+    uint16_t max_error;
+    uint16_t drift;
+  };
+  using model_storage_type =
+      std::conditional_t<kUseLearnedModel, node_model, no_search_layout>;
 
   struct base_fields {   // 3 | 5 -> 4 | 6 bytes
     field_type size;     // 1-2 byte (max = [255, 65535])
@@ -49,10 +161,18 @@ public:
     bool is_internal;    // 1 byte
   };
   struct leaf_fields : public base_fields {
-    value_type values[kTargetK];
+    slot_type values[kTargetK];
   };
   struct internal_fields : public leaf_fields {
-    self_type *pointers[kTargetK - 1];
+    // Leaves store their key column at the same place, see key_column().
+    [[no_unique_address]] key_column_type key_column;
+    child_handle_type pointers[kTargetK - 1];
+    uint64_t child_bits[kChildWords];
+    // Only present in internal nodes, leaves are allocated without it.
+    [[no_unique_address]] search_layout_type layout;
+    [[no_unique_address]] fence_storage_type fences;
+    [[no_unique_address]] prefix_storage_type prefixes;
+    [[no_unique_address]] model_storage_type model;
   };
 
   internal_fields fields;
@@ -76,7 +196,7 @@ public:
   // so we fall back to capacity of 1.
   static constexpr field_type kInitialCapacity_computed =
       static_cast<field_type>((WTREE_TARGET_INITIAL_BYTES - kBasefieldsBytes) /
-                              sizeof(value_type));
+                              sizeof(slot_type));
   static constexpr field_type kInitialCapacity =
       (kInitialCapacity_computed > 3) ? kInitialCapacity_computed : 3;
 
@@ -106,18 +226,18 @@ public:
 
   // Safe move function that works with both assignable and non-assignable
   // types.
-  static void safe_move_range(value_type *first, value_type *last,
-                              value_type *dest);
+  static void safe_move_range(slot_type *first, slot_type *last,
+                              slot_type *dest);
 
   // Safe move_backward function.
-  static void safe_move_backward_range(value_type *first, value_type *last,
-                                       value_type *dest_last);
+  static void safe_move_backward_range(slot_type *first, slot_type *last,
+                                       slot_type *dest_last);
 
   // Helper function to reverse a range for non-move-assignable types.
-  void reverse_range(value_type *first, value_type *last);
+  void reverse_range(slot_type *first, slot_type *last);
 
   // Safe rotate implementation that works with non-move-assignable types.
-  void safe_rotate(value_type *first, value_type *middle, value_type *last);
+  void safe_rotate(slot_type *first, slot_type *middle, slot_type *last);
 
   // template <typename... Args>
   // inline auto insert_value_impl(int i, Args &&...args)
@@ -186,24 +306,22 @@ public:
   // Getters for the key/value at position i in the node.
 
   inline const key_type &key(field_type i) const {
-    return params_type::get_key(fields.values[i]);
+    if constexpr (kUseKeyColumn)
+      return key_column()[i];
+    else
+      return params_type::get_key(value(i));
   }
   inline reference value(field_type i) {
-    return reinterpret_cast<reference>(fields.values[i]);
+    return params_type::element(fields.values[i]);
   }
   inline const_reference value(field_type i) const {
-    return reinterpret_cast<const_reference>(fields.values[i]);
+    return params_type::element(fields.values[i]);
   }
 
-  inline reference last_value() {
-    return reinterpret_cast<reference>(fields.values[size() - 1]);
-  }
-  inline const_reference last_value() const {
-    return reinterpret_cast<const_reference>(fields.values[size() - 1]);
-  }
+  inline reference last_value() { return value(size() - 1); }
+  inline const_reference last_value() const { return value(size() - 1); }
   template <typename Reference> inline Reference safe_last_value() {
-    return reinterpret_cast<Reference>(
-        fields.values[fields.size ? fields.size - 1 : 0]);
+    return value(fields.size ? fields.size - 1 : 0);
   }
 
   template <typename Compare>
@@ -218,19 +336,56 @@ public:
   // Swap value i in this node with value j in node x.
   void swap_value(int i, WTreeNode *x, int j) {
     assert(x != this || i != j);
-    params_type::swap(fields.values[i], x->fields.values[j]);
+    if constexpr (kUseOutOfLineValues)
+      std::swap(fields.values[i], x->fields.values[j]);
+    else
+      params_type::swap(fields.values[i], x->fields.values[j]);
+    if constexpr (kUseKeyColumn)
+      std::swap(key_column()[i], x->key_column()[j]);
+    if constexpr (kUseKeyPrefixes)
+      std::swap(key_prefixes()[i], x->key_prefixes()[j]);
+    invalidate_search_layout();
+    x->invalidate_search_layout();
   }
 
   // Swap value i in this node with value i in node x.
-  void swap_value(int i, WTreeNode *x) {
-    assert(x != this);
-    params_type::swap(fields.values[i], x->fields.values[i]);
-  }
+  void swap_value(int i, WTreeNode *x) { swap_value(i, x, i); }
 
   // Swap value i with value j.
-  void swap_value(int i, int j) {
-    assert(i != j);
-    params_type::swap(fields.values[i], fields.values[j]);
+  void swap_value(int i, int j) { swap_value(i, this, j); }
+
+  // Moves values [first, last) of src to dest, starting at d_first. The
+  // ranges may overlap when src == dest and d_first < first. Use these
+  // instead of safe_move_range on node values, so that the key column and
+  // the abbreviated keys move along with them.
+  static void move_values(WTreeNode *src, int first, int last,
+                          WTreeNode *dest, int d_first) {
+    safe_move_range(src->fields.values + first, src->fields.values + last,
+                    dest->fields.values + d_first);
+    copy_search_keys(src, first, last - first, dest, d_first);
+  }
+
+  // Moves values [first, last) of src to dest, ending at d_last. The ranges
+  // may overlap when src == dest and d_last > last.
+  static void move_values_backward(WTreeNode *src, int first, int last,
+                                   WTreeNode *dest, int d_last) {
+    safe_move_backward_range(src->fields.values + first,
+                             src->fields.values + last,
+                             dest->fields.values + d_last);
+    copy_search_keys(src, first, last - first, dest, d_last - (last - first));
+  }
+
+  // Copies the key column and the abbreviated keys of count values (which
+  // were moved or copied by other means) from src to dest.
+  static void copy_search_keys(const WTreeNode *src, int first, int count,
+                               WTreeNode *dest, int d_first) {
+    if constexpr (kUseKeyColumn)
+      std::memmove(static_cast<void *>(dest->key_column() + d_first),
+                   static_cast<const void *>(src->key_column() + first),
+                   count * sizeof(key_type));
+    if constexpr (kUseKeyPrefixes)
+      std::memmove(dest->key_prefixes() + d_first, src->key_prefixes() + first,
+                   count * sizeof(uint64_t));
   }
 
   // Move value i in this node to value j in node x.
@@ -257,12 +412,33 @@ public:
   // Getters/setter for the child at position i in the node.
   WTreeNode *child(field_type i) const {
     assert(!is_leaf());
-    return fields.pointers[i];
+    if constexpr (kUseChildHandles)
+      return static_cast<WTreeNode *>(
+          WTreeHandleSpan::decode(this, fields.pointers[i]));
+    else
+      return fields.pointers[i];
   }
 
   void set_child(field_type i, WTreeNode *c) {
     assert(is_internal());
-    fields.pointers[i] = c;
+    if constexpr (kUseChildHandles) {
+      fields.pointers[i] = c == nullptr ? 0 : WTreeHandleSpan::encode(c);
+      assert(child(i) == c);
+    } else {
+      fields.pointers[i] = c;
+    }
+    const uint64_t bit = uint64_t(1) << (i % 64);
+    if (c == nullptr)
+      fields.child_bits[i / 64] &= ~bit;
+    else
+      fields.child_bits[i / 64] |= bit;
+  }
+
+  // Leaves the node without children.
+  void clear_children() {
+    assert(is_internal());
+    memset(fields.pointers, 0, sizeof(fields.pointers));
+    memset(fields.child_bits, 0, sizeof(fields.child_bits));
   }
 
   // Swap child i in this node with child j in node x.
@@ -330,10 +506,18 @@ public:
   // returns false, routing through the plain compare path.
   template <typename Compare> static constexpr bool is_compare_to();
 
+  // Helper: the vector compare equivalent to comp, or kNone when the linear
+  // scan must stay scalar. Only arithmetic keys stored contiguously qualify:
+  // those of sets, and of maps with a key column (map values interleave the
+  // mapped data between keys).
+  template <typename Compare> static constexpr WTreeSimdOrder simd_order();
+
   // Unified node search — uses if constexpr on comp return type (int vs bool)
   // to handle both plain compare and compare_to. For compare_to binary search,
   // unique containers early-stop on exact match; multi containers recurse left.
-  template <typename Compare>
+  // Linear searches over numeric set keys use the WTreeSimdSearch kernel,
+  // unless Vectorize is false.
+  template <bool Vectorize = true, typename Compare>
   int linear_lower_bound_search(const key_type &query_key, int s, int e,
                                 const Compare &comp) const;
 
@@ -350,7 +534,7 @@ public:
                         const Compare &comp) const;
 
   // Bounded variants — assumes key is within [key(0), key(size-1)].
-  template <typename Compare>
+  template <bool Vectorize = true, typename Compare>
   int closed_linear_lower_bound_search(const key_type &query_key,
                                        const Compare &comp) const;
 
@@ -358,98 +542,410 @@ public:
   int closed_binary_lower_bound_search(const key_type &k,
                                        const Compare &comp) const;
 
+  // Branch-free binary search: the halving step is a conditional move, and
+  // both candidate midpoints of the next step are prefetched.
+  template <typename Compare>
+  int branchless_lower_bound_search(const key_type &k, int s, int e,
+                                    const Compare &comp) const;
+
+  template <typename Compare>
+  int closed_branchless_lower_bound_search(const key_type &k,
+                                           const Compare &comp) const;
+
+  // Interpolation search: one guess between the end keys, then an
+  // exponential search from the guess and a scan (or branch-free binary
+  // search) of the bracket. A bad guess costs about twice a binary search.
+  template <typename Compare>
+  int interpolation_lower_bound_search(const key_type &k, int s, int e,
+                                       const Compare &comp) const;
+
+  // Runs the kCustom kernel of the search policy, flagging exact matches
+  // for compare_to comparators like the built-in kernels do.
+  template <typename Compare>
+  int custom_lower_bound_search(const key_type &k, int s, int e,
+                                const Compare &comp) const {
+    const int pos = search_policy::lower_bound(*this, k, s, e, comp);
+    if constexpr (is_compare_to<Compare>()) {
+      if (pos < e && comp(key(pos), k) == 0)
+        return pos | kExactMatch;
+    }
+    return pos;
+  }
+
+  // Runs the given search method on [s, e), or on the closed range
+  // [key(0), key(size-1)]. Method must not be kAuto.
+  template <WTreeSearchMethod Method, typename Compare>
+  int lower_bound_search(const key_type &k, int s, int e,
+                         const Compare &comp) const {
+    static_assert(Method != WTreeSearchMethod::kAuto);
+    if constexpr (Method == WTreeSearchMethod::kLinear)
+      return linear_lower_bound_search<false>(k, s, e, comp);
+    else if constexpr (Method == WTreeSearchMethod::kSimd)
+      return linear_lower_bound_search(k, s, e, comp);
+    else if constexpr (Method == WTreeSearchMethod::kBinary)
+      return binary_lower_bound_search(k, s, e, comp);
+    else if constexpr (Method == WTreeSearchMethod::kInterpolation)
+      return interpolation_lower_bound_search(k, s, e, comp);
+    else if constexpr (Method == WTreeSearchMethod::kCustom)
+      return custom_lower_bound_search(k, s, e, comp);
+    else
+      return branchless_lower_bound_search(k, s, e, comp);
+  }
+
+  template <WTreeSearchMethod Method, typename Compare>
+  int closed_lower_bound_search(const key_type &k, const Compare &comp) const {
+    static_assert(Method != WTreeSearchMethod::kAuto);
+    if constexpr (Method == WTreeSearchMethod::kLinear)
+      return closed_linear_lower_bound_search<false>(k, comp);
+    else if constexpr (Method == WTreeSearchMethod::kSimd)
+      return closed_linear_lower_bound_search(k, comp);
+    else if constexpr (Method == WTreeSearchMethod::kBinary)
+      return closed_binary_lower_bound_search(k, comp);
+    else if constexpr (Method == WTreeSearchMethod::kInterpolation)
+      return interpolation_lower_bound_search(k, 0, size(), comp);
+    else if constexpr (Method == WTreeSearchMethod::kCustom)
+      return custom_lower_bound_search(k, 0, size(), comp);
+    else
+      return closed_branchless_lower_bound_search(k, comp);
+  }
+
+  // Branch-free search over the Eytzinger copy of a full internal node,
+  // prefetching the block of keys four levels below the current one.
+  template <typename Compare>
+  int eytzinger_lower_bound_search(const key_type &k,
+                                   const Compare &comp) const;
+
+  // Searches the abbreviated keys, then compares full keys only within the
+  // range of prefixes equal to the prefix of k.
+  template <typename Compare>
+  int prefix_lower_bound_search(const key_type &k, int s, int e,
+                                const Compare &comp) const;
+
+  // Scans the fence index, then the single block of kFenceStride keys that
+  // holds the answer.
+  template <typename Compare>
+  int fenced_lower_bound_search(const key_type &k, const Compare &comp) const;
+
+  // Whether the fence index is used for a node of the current size.
+  bool use_fences() const {
+    if constexpr (kUseFences)
+      return size() >= 2 * kFenceStride;
+    else
+      return false;
+  }
+
+  // Predicts the slot of k with the learned model and searches only the
+  // window of slots around it; falls back to a full search (and a refit on
+  // the next search) when the answer is outside that window.
+  template <typename Compare>
+  int model_lower_bound_search(const key_type &k, const Compare &comp) const;
+
+  // Whether the learned model is used for a node of the current size.
+  bool use_model() const {
+    if constexpr (kUseLearnedModel)
+      return size() >= kModelMinKeys;
+    else
+      return false;
+  }
+
+  // Marks the Eytzinger copy and the fence index as outdated, and counts a
+  // modification against the learned model. Must be called whenever the
+  // keys of a node change; construct/destroy/swap_value already do. The
+  // routine writing the node calls refresh_search_layout once its values
+  // are in place again, so that searches only ever read the copies.
+  void invalidate_search_layout() {
+    if constexpr (kUseEytzingerLayout)
+      if (is_internal())
+        fields.layout.stale = true;
+    if constexpr (kUseFences)
+      fence_stale() = true;
+    if constexpr (kUseLearnedModel)
+      if (model().drift <= kModelRefitDrift)
+        ++model().drift;
+  }
+
+  // Like invalidate_search_layout, for a node whose search copies hold
+  // nothing yet (new or reallocated nodes): the model must be refit too.
+  void reset_search_layout() {
+    if constexpr (kUseLearnedModel)
+      model().drift = kModelRefitDrift + 1;
+    invalidate_search_layout();
+  }
+
+  // Rebuilds the search copies marked outdated. To be called at the end of
+  // every write to the node, when its values are all constructed.
+  void refresh_search_layout() {
+    if constexpr (kUseEytzingerLayout)
+      if (is_internal() && size() == kTargetK && fields.layout.stale)
+        rebuild_search_layout();
+    if constexpr (kUseFences)
+      if (fence_stale())
+        rebuild_fences();
+    if constexpr (kUseLearnedModel)
+      if (use_model() && model().drift > kModelRefitDrift)
+        refit_model();
+  }
+
+  void rebuild_search_layout();
+  void rebuild_fences();
+  void refit_model();
+
+  // Recomputes the key column and every abbreviated key, after values were
+  // written directly.
+  void rebuild_search_keys() {
+    if constexpr (kUseKeyColumn)
+      for (int i = 0; i < size(); ++i)
+        key_column()[i] = params_type::get_key(value(i));
+    if constexpr (kUseKeyPrefixes)
+      for (int i = 0; i < size(); ++i)
+        key_prefixes()[i] = WTreeKeyPrefix<key_type>::get(key(i));
+  }
+
+  // To be called after writing values directly (not through the value
+  // routines): refreshes every search copy of the node.
+  void refresh_search_copies() {
+    reset_search_layout();
+    rebuild_search_keys();
+    refresh_search_layout();
+  }
+
+  key_type *key_column() const {
+    return reinterpret_cast<key_type *>(
+        const_cast<slot_type *>(fields.values + capacity()));
+  }
+
+  // The keys of the node as a contiguous array, for the vectorized scans
+  // (see simd_order).
+  const key_type *key_array() const {
+    if constexpr (kUseKeyColumn)
+      return key_column();
+    else
+      return fields.values;
+  }
+
+  uint64_t *key_prefixes() const {
+    const void *prefixes =
+        is_internal() ? static_cast<const void *>(&fields.prefixes)
+                      : reinterpret_cast<const char *>(fields.values +
+                                                       capacity()) +
+                            key_column_bytes(capacity());
+    return static_cast<uint64_t *>(const_cast<void *>(prefixes));
+  }
+
+  // Bytes of the key column of a leaf with the given capacity, padded for
+  // the abbreviated keys that follow it.
+  static constexpr size_t key_column_bytes(field_type capacity) {
+    return kUseKeyColumn ? (capacity * sizeof(key_type) + 7) / 8 * 8 : 0;
+  }
+
+  // Bytes of the abbreviated keys of a leaf with the given capacity.
+  static constexpr size_t prefix_bytes(field_type capacity) {
+    return kUseKeyPrefixes ? capacity * sizeof(uint64_t) : 0;
+  }
+
+  // Bytes of the fence index of a node with the given capacity.
+  static constexpr size_t fence_bytes(field_type capacity) {
+    if constexpr (kUseFences)
+      return kFenceKeysOffset + (capacity / kFenceStride) * sizeof(key_type);
+    else
+      return 0;
+  }
+
+  // Byte offset of the learned model in a leaf with the given capacity.
+  static constexpr size_t model_offset(field_type capacity) {
+    const size_t end = kBasefieldsBytes + capacity * sizeof(slot_type) +
+                       key_column_bytes(capacity) + prefix_bytes(capacity) +
+                       fence_bytes(capacity);
+    return (end + alignof(node_model) - 1) / alignof(node_model) *
+           alignof(node_model);
+  }
+
+  // Bytes allocated for a leaf with the given capacity.
+  static constexpr size_t leaf_bytes(field_type capacity) {
+    if constexpr (kUseLearnedModel)
+      return model_offset(capacity) + sizeof(node_model);
+    else
+      return kBasefieldsBytes + capacity * sizeof(slot_type) +
+             key_column_bytes(capacity) + prefix_bytes(capacity) +
+             fence_bytes(capacity);
+  }
+
+  char *fence_region() const {
+    const char *region =
+        is_internal() ? reinterpret_cast<const char *>(&fields.fences)
+                      : reinterpret_cast<const char *>(fields.values +
+                                                       capacity()) +
+                            key_column_bytes(capacity()) +
+                            prefix_bytes(capacity());
+    return const_cast<char *>(region);
+  }
+  bool &fence_stale() const {
+    return *reinterpret_cast<bool *>(fence_region());
+  }
+  key_type *fence_keys() const {
+    return reinterpret_cast<key_type *>(fence_region() + kFenceKeysOffset);
+  }
+
+  node_model &model() const {
+    const void *m = is_internal() ? static_cast<const void *>(&fields.model)
+                                  : reinterpret_cast<const char *>(this) +
+                                        model_offset(capacity());
+    return *static_cast<node_model *>(const_cast<void *>(m));
+  }
+
+  // Number of keys from which kAuto searches a node with kBinaryMethod: the
+  // calibrated value when kUseCalibratedThreshold, else a constant.
+  static uint binary_search_threshold() {
+    if constexpr (kUseCalibratedThreshold)
+      return params_type::calibrated_threshold::value;
+    else
+      return kBinarySearchThreshold;
+  }
+
   // =====================================================================
-  // Public node search API — picks linear vs binary, calls directly.
-  // Internal nodes: compile-time decision (always full at kTargetK keys).
+  // Public node search API — picks the search method, calls directly.
+  // Internal nodes: decided on kTargetK (they are always full).
   // Leaf nodes: runtime hybrid check (variable fill).
   // Upper bound: wraps comparator via make_upper_comp.
+  // Method forces a WTreeSearchMethod; it defaults to the method of the
+  // container's search policy, and kAuto keeps the per-node-kind choice.
   // =====================================================================
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kInternalSearchMethod, typename Compare>
   int lower_bound_internal(const key_type &key, const Compare &comp) const {
-    if constexpr (kUseBinarySearchForInternal)
-      return binary_lower_bound_search(key, 0, size(), comp);
-    else
+    if constexpr (Method != WTreeSearchMethod::kAuto) {
+      return lower_bound_search<Method>(key, 0, size(), comp);
+    } else {
+      if constexpr (kUseKeyPrefixes)
+        return prefix_lower_bound_search(key, 0, size(), comp);
+      if constexpr (kUseEytzingerLayout)
+        if (size() == kTargetK)
+          return eytzinger_lower_bound_search(key, comp);
+      if constexpr (kUseLearnedModel)
+        if (use_model())
+          return model_lower_bound_search(key, comp);
+      if (use_fences())
+        return fenced_lower_bound_search(key, comp);
+      if (kTargetK >= binary_search_threshold())
+        return lower_bound_search<kBinaryMethod>(key, 0, size(), comp);
       return linear_lower_bound_search(key, 0, size(), comp);
+    }
   }
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kLeafSearchMethod, typename Compare>
   int lower_bound_leaf(const key_type &key, const Compare &comp) const {
-    if (size() >= kBinarySearchThreshold)
-      return binary_lower_bound_search(key, 0, size(), comp);
-    return linear_lower_bound_search(key, 0, size(), comp);
+    if constexpr (Method != WTreeSearchMethod::kAuto) {
+      return lower_bound_search<Method>(key, 0, size(), comp);
+    } else {
+      if constexpr (kUseKeyPrefixes)
+        return prefix_lower_bound_search(key, 0, size(), comp);
+      if constexpr (kUseLearnedModel)
+        if (use_model())
+          return model_lower_bound_search(key, comp);
+      if (use_fences())
+        return fenced_lower_bound_search(key, comp);
+      if (size() >= binary_search_threshold())
+        return lower_bound_search<kBinaryMethod>(key, 0, size(), comp);
+      return linear_lower_bound_search(key, 0, size(), comp);
+    }
   }
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kInternalSearchMethod, typename Compare>
   int upper_bound_internal(const key_type &key, const Compare &comp) const {
-    auto uc = make_upper_comp(comp);
-    if constexpr (kUseBinarySearchForInternal)
-      return binary_lower_bound_search(key, 0, size(), uc);
-    else
-      return linear_lower_bound_search(key, 0, size(), uc);
+    return lower_bound_internal<Method>(key, make_upper_comp(comp));
   }
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kLeafSearchMethod, typename Compare>
   int upper_bound_leaf(const key_type &key, const Compare &comp) const {
-    auto uc = make_upper_comp(comp);
-    if (size() >= kBinarySearchThreshold)
-      return binary_lower_bound_search(key, 0, size(), uc);
-    return linear_lower_bound_search(key, 0, size(), uc);
+    return lower_bound_leaf<Method>(key, make_upper_comp(comp));
   }
 
   // Bounded lower bound — key within [key(0), key(size-1)].
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kInternalSearchMethod, typename Compare>
   int bounded_lower_bound_internal(const key_type &key,
                                    const Compare &comp) const {
-    if constexpr (kUseBinarySearchForInternal)
-      return closed_binary_lower_bound_search(key, comp);
-    else
+    if constexpr (Method != WTreeSearchMethod::kAuto) {
+      return closed_lower_bound_search<Method>(key, comp);
+    } else {
+      if constexpr (kUseKeyPrefixes)
+        return prefix_lower_bound_search(key, 0, size(), comp);
+      if constexpr (kUseEytzingerLayout)
+        if (size() == kTargetK)
+          return eytzinger_lower_bound_search(key, comp);
+      if constexpr (kUseLearnedModel)
+        if (use_model())
+          return model_lower_bound_search(key, comp);
+      if (use_fences())
+        return fenced_lower_bound_search(key, comp);
+      if (kTargetK >= binary_search_threshold())
+        return closed_lower_bound_search<kBinaryMethod>(key, comp);
       return closed_linear_lower_bound_search(key, comp);
+    }
   }
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kLeafSearchMethod, typename Compare>
   int bounded_lower_bound_leaf(const key_type &key, const Compare &comp) const {
-    if (size() >= kBinarySearchThreshold)
-      return closed_binary_lower_bound_search(key, comp);
-    return closed_linear_lower_bound_search(key, comp);
+    if constexpr (Method != WTreeSearchMethod::kAuto) {
+      return closed_lower_bound_search<Method>(key, comp);
+    } else {
+      if constexpr (kUseKeyPrefixes)
+        return prefix_lower_bound_search(key, 0, size(), comp);
+      if constexpr (kUseLearnedModel)
+        if (use_model())
+          return model_lower_bound_search(key, comp);
+      if (use_fences())
+        return fenced_lower_bound_search(key, comp);
+      if (size() >= binary_search_threshold())
+        return closed_lower_bound_search<kBinaryMethod>(key, comp);
+      return closed_linear_lower_bound_search(key, comp);
+    }
   }
 
   // Bounded upper bound — key within [key(0), key(size-1)].
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kInternalSearchMethod, typename Compare>
   int bounded_upper_bound_internal(const key_type &key,
                                    const Compare &comp) const {
-    auto uc = make_upper_comp(comp);
-    if constexpr (kUseBinarySearchForInternal)
-      return closed_binary_lower_bound_search(key, uc);
-    else
-      return closed_linear_lower_bound_search(key, uc);
+    return bounded_lower_bound_internal<Method>(key, make_upper_comp(comp));
   }
 
-  template <typename Compare>
+  template <WTreeSearchMethod Method = kLeafSearchMethod, typename Compare>
   int bounded_upper_bound_leaf(const key_type &key, const Compare &comp) const {
-    auto uc = make_upper_comp(comp);
-    if (size() >= kBinarySearchThreshold)
-      return closed_binary_lower_bound_search(key, uc);
-    return closed_linear_lower_bound_search(key, uc);
+    return bounded_lower_bound_leaf<Method>(key, make_upper_comp(comp));
   }
 
   // Returns at index (kTargetK - 1) when no descendant was found,
   // which is the last key index (with no right descendant).
-  template <typename T> T first_right_descendant(T from) {
+  template <typename T> T first_right_descendant(T from) const {
     assert(is_internal());
-    for (; from < kTargetK - 1 && child(from) == nullptr; ++from)
-      ;
-    return from;
+    if (from >= kTargetK - 1)
+      return from;
+    size_t w = from / 64;
+    uint64_t bits = fields.child_bits[w] & (~uint64_t(0) << (from % 64));
+    while (bits == 0) {
+      if (++w == kChildWords)
+        return kTargetK - 1;
+      bits = fields.child_bits[w];
+    }
+    return static_cast<T>(w * 64 + std::countr_zero(bits));
   }
 
   // Returns 0 if no child exist at the left of the [from] value index.
   // This is correct because for a value at index [from]=0 has no left child,
   // and is also efficient as we can use an unsigned [field_type].
-  template <typename T> T first_left_descendant(T from) {
+  template <typename T> T first_left_descendant(T from) const {
     assert(is_internal());
-    for (; from > 0 && child(from - 1) == nullptr; --from)
-      ;
-    return from;
+    if (from == 0)
+      return 0;
+    // Children [0, from) are to the left.
+    size_t w = (from - 1) / 64;
+    uint64_t bits =
+        fields.child_bits[w] & (~uint64_t(0) >> (63 - (from - 1) % 64));
+    while (bits == 0) {
+      if (w-- == 0)
+        return 0;
+      bits = fields.child_bits[w];
+    }
+    return static_cast<T>(w * 64 + 64 - std::countl_zero(bits));
   }
 
   // #endregion
@@ -488,9 +984,10 @@ public:
     u->fields.is_internal = false;
 
 #ifndef NDEBUG
-    void *res = memset(&(u->values), 0, init_capacity * sizeof(value_type));
+    void *res = memset(&(u->values), 0, init_capacity * sizeof(slot_type));
     assert(res != nullptr);
 #endif
+    reinterpret_cast<WTreeNode *>(u)->reset_search_layout();
     return reinterpret_cast<WTreeNode *>(u);
   }
 
@@ -502,34 +999,41 @@ public:
     void *res;
 
 #ifndef NDEBUG
-    res = memset(&(node->fields.values), 0, kTargetK * sizeof(value_type));
+    res = memset(&(node->fields.values), 0, kTargetK * sizeof(slot_type));
     assert(res != nullptr);
 #endif
 
-    res = memset(node->fields.pointers, 0, sizeof(node->fields.pointers));
-    assert(res != nullptr);
+    node->clear_children();
+    assert(!kUseKeyColumn || static_cast<void *>(node->key_column()) ==
+                                 static_cast<void *>(&node->fields.key_column));
+    node->reset_search_layout();
     return node;
   }
 
 private:
-  static constexpr const char zero_value[sizeof(value_type)] = {};
+  static constexpr const char zero_value[sizeof(slot_type)] = {};
 
 public:
   template <typename... Args>
-  void construct_value(value_type *v, Args &&...args) {
-    new (static_cast<void *>(v)) value_type(std::forward<Args>(args)...);
+  void construct_value(slot_type *v, Args &&...args) {
+    new (static_cast<void *>(v)) slot_type(std::forward<Args>(args)...);
   }
 
   template <typename... Args> void construct_value(int i, Args &&...args) {
     assert(i >= 0);
     assert(i < fields.capacity);
     construct_value(&fields.values[i], std::forward<Args>(args)...);
+    if constexpr (kUseKeyColumn)
+      key_column()[i] = params_type::get_key(value(i));
+    if constexpr (kUseKeyPrefixes)
+      key_prefixes()[i] = WTreeKeyPrefix<key_type>::get(key(i));
+    invalidate_search_layout();
   }
 
-  void destroy_value(value_type *v) {
-    v->~value_type();
+  void destroy_value(slot_type *v) {
+    v->~slot_type();
 #ifndef NDEBUG
-    memcpy(static_cast<void *>(v), zero_value, sizeof(value_type));
+    memcpy(static_cast<void *>(v), zero_value, sizeof(slot_type));
 #endif
   }
 
@@ -539,6 +1043,7 @@ public:
       return;
     assert(i < kTargetK);
     destroy_value(&fields.values[i]);
+    invalidate_search_layout();
   }
 };
 
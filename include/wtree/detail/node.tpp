@@ -3,7 +3,10 @@
 
 #include "node.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cmath>
 
 namespace WTreeLib {
 
@@ -14,11 +17,17 @@ inline void WTreeNode<Params>::internal_emplace_as_leaf(field_type i,
   const field_type cnt = size();
   assert(i <= cnt);
 
-  if constexpr (std::is_trivially_move_assignable_v<value_type>) {
+  if constexpr (std::is_trivially_move_assignable_v<slot_type>) {
     // Trivially move-assignable: rotate compiles to memmove.
     construct_value(cnt, std::forward<Args>(args)...);
     std::rotate(fields.values + i, fields.values + cnt,
                 fields.values + cnt + 1);
+    if constexpr (kUseKeyColumn)
+      std::rotate(key_column() + i, key_column() + cnt,
+                  key_column() + cnt + 1);
+    if constexpr (kUseKeyPrefixes)
+      std::rotate(key_prefixes() + i, key_prefixes() + cnt,
+                  key_prefixes() + cnt + 1);
   } else {
     // Non-trivial types: shift right and construct in-place at i.
     if (i == cnt) {
@@ -95,13 +104,30 @@ constexpr bool WTreeNode<Params>::is_compare_to() {
   return std::is_same_v<result_t, int>;
 }
 
+template <typename Params>
+template <typename Compare>
+constexpr WTreeSimdOrder WTreeNode<Params>::simd_order() {
+  if constexpr ((std::is_same_v<value_type, key_type> || kUseKeyColumn) &&
+                WTreeSimdSearch<key_type>::kSupported)
+    return WTreeSimdCompareOrder<key_type, Compare>::value;
+  else
+    return WTreeSimdOrder::kNone;
+}
+
 // --- Unbounded search ---
 
 template <typename Params>
-template <typename Compare>
+template <bool Vectorize, typename Compare>
 int WTreeNode<Params>::linear_lower_bound_search(const key_type &query_key,
                                                  int s, int e,
                                                  const Compare &comp) const {
+  if constexpr (Vectorize && simd_order<Compare>() != WTreeSimdOrder::kNone) {
+    constexpr bool or_equal =
+        simd_order<Compare>() == WTreeSimdOrder::kLessEqual;
+    return WTreeSimdSearch<key_type>::template bound<or_equal>(
+        key_array(), s, e, query_key);
+  }
+
   while (s < e) {
     if constexpr (is_compare_to<Compare>()) {
       int c = comp(key(s), query_key);
@@ -211,9 +237,16 @@ int WTreeNode<Params>::binary_search_any(const key_type &k, int s, int e,
 // --- Bounded search (key within [key(0), key(size-1)]) ---
 
 template <typename Params>
-template <typename Compare>
+template <bool Vectorize, typename Compare>
 int WTreeNode<Params>::closed_linear_lower_bound_search(
     const key_type &query_key, const Compare &comp) const {
+  if constexpr (Vectorize && simd_order<Compare>() != WTreeSimdOrder::kNone) {
+    constexpr bool or_equal =
+        simd_order<Compare>() == WTreeSimdOrder::kLessEqual;
+    return WTreeSimdSearch<key_type>::template bound<or_equal>(
+        key_array(), 0, size(), query_key);
+  }
+
   field_type index = 0;
   if constexpr (is_compare_to<Compare>()) {
     for (;; ++index) {
@@ -268,12 +301,349 @@ int WTreeNode<Params>::closed_binary_lower_bound_search(
   }
   return left;
 }
+
+// --- Branch-free binary search ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::branchless_lower_bound_search(
+    const key_type &k, int s, int e, const Compare &comp) const {
+  if (s >= e)
+    return s;
+
+  // Invariant: the answer is in [base, base + n].
+  int base = s;
+  int n = e - s;
+  while (n > 1) {
+    const int half = n / 2;
+    WTREE_PREFETCH(&key(base + half / 2));
+    WTREE_PREFETCH(&key(base + half + half / 2));
+    bool less;
+    if constexpr (is_compare_to<Compare>())
+      less = comp(key(base + half), k) < 0;
+    else
+      less = comp(key(base + half), k);
+    base = less ? base + half : base;
+    n -= half;
+  }
+
+  int pos;
+  if constexpr (is_compare_to<Compare>()) {
+    const int c = comp(key(base), k);
+    if (c == 0)
+      return base | kExactMatch;
+    pos = base + (c < 0);
+    if (pos < e && comp(key(pos), k) == 0)
+      return pos | kExactMatch;
+  } else {
+    pos = base + comp(key(base), k);
+  }
+  return pos;
+}
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::closed_branchless_lower_bound_search(
+    const key_type &k, const Compare &comp) const {
+  // Bounded guarantee: the answer is in [0, size()-1], so the last key
+  // never needs to be compared.
+  if constexpr (is_compare_to<Compare>()) {
+    const int pos = branchless_lower_bound_search(k, 0, size() - 1, comp);
+    if (!(pos & kExactMatch) && comp(key(pos), k) == 0)
+      return pos | kExactMatch;
+    return pos;
+  } else {
+    return branchless_lower_bound_search(k, 0, size() - 1, comp);
+  }
+}
+
+// --- Interpolation search ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::interpolation_lower_bound_search(
+    const key_type &k, int s, int e, const Compare &comp) const {
+  constexpr WTreeSimdOrder order =
+      WTreeSimdCompareOrder<key_type, Compare>::value;
+  if constexpr (!std::is_arithmetic_v<key_type> ||
+                order == WTreeSimdOrder::kNone) {
+    // Guessing positions needs arithmetic keys in their natural order.
+    return lower_bound_search<kBinaryMethod>(k, s, e, comp);
+  } else {
+    // Whether x lies left of the answer (x < k, or x <= k for upper bounds).
+    auto left_of = [&k](const key_type &x) {
+      if constexpr (order == WTreeSimdOrder::kLessEqual)
+        return !(k < x);
+      else
+        return x < k;
+    };
+
+    // Invariant: the answer is in [lo, hi].
+    int lo = s, hi = e;
+    if (hi - lo > kInterpolationLinearRange) {
+      const key_type &first = key(lo);
+      const key_type &last = key(hi - 1);
+      if (!left_of(first)) {
+        hi = lo;
+      } else if (left_of(last)) {
+        lo = hi;
+      } else {
+        double frac = (static_cast<double>(k) - static_cast<double>(first)) /
+                      (static_cast<double>(last) - static_cast<double>(first));
+        if (!(frac >= 0.0 && frac <= 1.0))
+          frac = 0.5;
+        const int guess = lo + static_cast<int>(frac * (hi - 1 - lo));
+
+        // Exponential search away from the guess until the answer is
+        // bracketed.
+        int step = 1;
+        if (left_of(key(guess))) {
+          lo = guess + 1;
+          for (int p = lo; p < hi; p = lo + step - 1) {
+            if (!left_of(key(p))) {
+              hi = p;
+              break;
+            }
+            lo = p + 1;
+            step <<= 1;
+          }
+        } else {
+          hi = guess;
+          for (int p = hi - 1; p >= lo; p = hi - step) {
+            if (left_of(key(p))) {
+              lo = p + 1;
+              break;
+            }
+            hi = p;
+            step <<= 1;
+          }
+        }
+      }
+    }
+
+    const int pos = hi - lo <= kInterpolationLinearRange
+                        ? linear_lower_bound_search(k, lo, hi, comp)
+                        : branchless_lower_bound_search(k, lo, hi, comp);
+    if constexpr (is_compare_to<Compare>()) {
+      if (!(pos & kExactMatch) && pos < e && comp(key(pos), k) == 0)
+        return pos | kExactMatch;
+    }
+    return pos;
+  }
+}
+
+// --- Abbreviated key search ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::prefix_lower_bound_search(const key_type &k, int s,
+                                                 int e,
+                                                 const Compare &comp) const {
+  if constexpr (WTreeSimdCompareOrder<key_type, Compare>::value ==
+                WTreeSimdOrder::kNone) {
+    // Prefixes only follow the natural order of the keys.
+    return binary_lower_bound_search(k, s, e, comp);
+  } else {
+    const uint64_t *prefixes = key_prefixes();
+    const uint64_t q = WTreeKeyPrefix<key_type>::get(k);
+
+    // Keys with a smaller (larger) prefix are smaller (larger) than k, so
+    // only [lo, hi), where prefixes tie, needs full key compares.
+    auto bound = [prefixes, q](int lo, int hi, auto or_equal) {
+      while (hi - lo > 32) {
+        const int mid = lo + (hi - lo) / 2;
+        const bool left = decltype(or_equal)::value ? prefixes[mid] <= q
+                                                    : prefixes[mid] < q;
+        lo = left ? mid + 1 : lo;
+        hi = left ? hi : mid;
+      }
+      return WTreeSimdSearch<uint64_t>::template bound<
+          decltype(or_equal)::value>(prefixes, lo, hi, q);
+    };
+    const int lo = bound(s, e, std::false_type{});
+    const int hi = bound(lo, e, std::true_type{});
+    if (lo == hi)
+      return lo;
+    return binary_lower_bound_search(k, lo, hi, comp);
+  }
+}
+
+// --- Fence index search ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::fenced_lower_bound_search(const key_type &k,
+                                                 const Compare &comp) const {
+  assert(use_fences() && !fence_stale());
+
+  // fences[j] is the last key of block j, so the answer lies in the first
+  // block whose fence does not compare less than k (or in the tail).
+  const key_type *fences = fence_keys();
+  const int n = size() / kFenceStride;
+  int block = 0;
+  if constexpr (WTreeSimdSearch<key_type>::kSupported &&
+                WTreeSimdCompareOrder<key_type, Compare>::value !=
+                    WTreeSimdOrder::kNone) {
+    constexpr bool or_equal = WTreeSimdCompareOrder<key_type, Compare>::value ==
+                              WTreeSimdOrder::kLessEqual;
+    block = WTreeSimdSearch<key_type>::template bound<or_equal>(fences, 0, n,
+                                                                 k);
+  } else {
+    for (; block < n; ++block) {
+      if constexpr (is_compare_to<Compare>()) {
+        if (comp(fences[block], k) >= 0)
+          break;
+      } else {
+        if (!comp(fences[block], k))
+          break;
+      }
+    }
+  }
+
+  const int s = block * kFenceStride;
+  const int e = std::min<int>(s + kFenceStride, size());
+  return linear_lower_bound_search(k, s, e, comp);
+}
+
+template <typename Params>
+void WTreeNode<Params>::rebuild_fences() {
+  if constexpr (kUseFences) {
+    key_type *fences = fence_keys();
+    const int n = size() / kFenceStride;
+    for (int j = 0; j < n; ++j)
+      std::memcpy(static_cast<void *>(fences + j),
+                  static_cast<const void *>(&key((j + 1) * kFenceStride - 1)),
+                  sizeof(key_type));
+    fence_stale() = false;
+  }
+}
+
+// --- Learned model search ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::model_lower_bound_search(const key_type &k,
+                                                const Compare &comp) const {
+  assert(use_model() && model().drift <= kModelRefitDrift);
+  const node_model &m = model();
+
+  // Whether x lies left of the answer.
+  auto left_of = [&comp, &k](const key_type &x) {
+    if constexpr (is_compare_to<Compare>())
+      return comp(x, k) < 0;
+    else
+      return static_cast<bool>(comp(x, k));
+  };
+
+  // The prediction is monotonic in k, so it lies within max_error + 1 of
+  // the answer for the keys the model was fit on; every later modification
+  // may shift the answer by one more slot.
+  const int n = size();
+  const double guess = m.intercept + m.slope * static_cast<double>(k);
+  const int p = !(guess >= 0) ? 0 : guess >= n ? n : static_cast<int>(guess);
+  const int window = m.max_error + m.drift + 1;
+  const int lo = std::max(0, p - window);
+  const int hi = std::min(n, p + window + 1);
+
+  if ((lo == 0 || left_of(key(lo - 1))) && (hi == n || !left_of(key(hi)))) {
+    const int pos = hi - lo <= kInterpolationLinearRange
+                        ? linear_lower_bound_search(k, lo, hi, comp)
+                        : lower_bound_search<kBinaryMethod>(k, lo, hi, comp);
+    if constexpr (is_compare_to<Compare>()) {
+      if (!(pos & kExactMatch) && pos < n && comp(key(pos), k) == 0)
+        return pos | kExactMatch;
+    }
+    return pos;
+  }
+
+  // The keys moved too far from the model since the fit.
+  return lower_bound_search<kBinaryMethod>(k, 0, n, comp);
+}
+
+template <typename Params>
+void WTreeNode<Params>::refit_model() {
+  if constexpr (kUseLearnedModel) {
+    node_model &m = model();
+    const int n = size();
+
+    // Least squares fit of slot over key, centered for precision.
+    double mean_x = 0;
+    for (int i = 0; i < n; ++i)
+      mean_x += static_cast<double>(key(i));
+    mean_x /= n;
+    const double mean_y = (n - 1) / 2.0;
+    double sxx = 0, sxy = 0;
+    for (int i = 0; i < n; ++i) {
+      const double dx = static_cast<double>(key(i)) - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (i - mean_y);
+    }
+    m.slope = sxx > 0 ? sxy / sxx : 0;
+    m.intercept = mean_y - m.slope * mean_x;
+
+    // A NaN error (infinite or NaN keys) saturates to the whole node.
+    double error = 0;
+    for (int i = 0; i < n; ++i) {
+      const double e =
+          std::fabs(m.intercept + m.slope * static_cast<double>(key(i)) - i);
+      if (!(e <= error))
+        error = e;
+    }
+    m.max_error = error < UINT16_MAX ? static_cast<uint16_t>(std::ceil(error))
+                                     : UINT16_MAX;
+    m.drift = 0;
+  }
+}
+
+// --- Eytzinger search (full internal nodes) ---
+
+template <typename Params>
+template <typename Compare>
+int WTreeNode<Params>::eytzinger_lower_bound_search(
+    const key_type &k, const Compare &comp) const {
+  assert(is_internal() && size() == kTargetK && !fields.layout.stale);
+
+  // Keys of the subtree four levels down share a cache line (or a few).
+  constexpr size_t kPrefetchStride =
+      std::max<size_t>(1, 64 / sizeof(key_type));
+  const key_type *keys = fields.layout.keys;
+  size_t i = 1;
+  while (i <= kTargetK) {
+    WTREE_PREFETCH(keys + std::min<size_t>(i * kPrefetchStride, kTargetK));
+    if constexpr (is_compare_to<Compare>())
+      i = 2 * i + (comp(keys[i], k) < 0);
+    else
+      i = 2 * i + comp(keys[i], k);
+  }
+  // Drop the trailing right turns (and the last left one) to get the slot
+  // of the answer; zero means every key compares less.
+  i >>= std::countr_one(i) + 1;
+  const int pos =
+      i == 0 ? kTargetK : kWTreeEytzingerOrder<field_type, kTargetK>[i];
+
+  if constexpr (is_compare_to<Compare>()) {
+    if (pos < kTargetK && comp(key(pos), k) == 0)
+      return pos | kExactMatch;
+  }
+  return pos;
+}
+
+template <typename Params>
+void WTreeNode<Params>::rebuild_search_layout() {
+  if constexpr (kUseEytzingerLayout) {
+    assert(is_internal() && size() == kTargetK);
+    const auto &order = kWTreeEytzingerOrder<field_type, kTargetK>;
+    for (size_t i = 1; i <= kTargetK; ++i)
+      fields.layout.keys[i] = key(order[i]);
+    fields.layout.stale = false;
+  }
+}
 // #endregion
 
 // === Helper functions to generalize std::move and std::move_backward. ===
 template <typename Params>
-void WTreeNode<Params>::safe_move_range(value_type *first, value_type *last,
-                                        value_type *dest) {
+void WTreeNode<Params>::safe_move_range(slot_type *first, slot_type *last,
+                                        slot_type *dest) {
   const size_t count = last - first;
   if (count == 0)
     return;
@@ -287,42 +657,53 @@ void WTreeNode<Params>::safe_move_range(value_type *first, value_type *last,
   const bool overlapping = !(dest + count <= first || dest >= last);
 
   if (!overlapping) {
-    if constexpr (std::is_move_constructible_v<value_type>) {
+    if constexpr (std::is_move_constructible_v<slot_type>) {
       for (size_t i = 0; i < count; ++i) {
-        new (&dest[i]) value_type(std::move(first[i]));
-        first[i].~value_type();
+        new (&dest[i]) slot_type(std::move(first[i]));
+        first[i].~slot_type();
       }
     } else {
       for (size_t i = 0; i < count; ++i) {
-        new (&dest[i]) value_type(first[i]);
-        first[i].~value_type();
+        new (&dest[i]) slot_type(first[i]);
+        first[i].~slot_type();
       }
     }
-  } else if constexpr (std::is_move_assignable_v<value_type>) {
-    // Overlapping within the same node: slots are already alive.
+  } else if constexpr (std::is_trivially_copyable_v<slot_type>) {
     std::move(first, last, dest);
-  } else if constexpr (std::is_move_constructible_v<value_type>) {
+  } else if constexpr (std::is_move_assignable_v<slot_type>) {
+    // Overlapping within the same node: the source slots are alive, the
+    // destination slots before them may not be.
+    for (size_t i = 0; i < count; ++i) {
+      if (&dest[i] < first)
+        new (&dest[i]) slot_type(std::move(first[i]));
+      else
+        dest[i] = std::move(first[i]);
+    }
+    // The moved-out slots past the destination are left empty.
+    for (slot_type *p = dest + count; p < last; ++p)
+      p->~slot_type();
+  } else if constexpr (std::is_move_constructible_v<slot_type>) {
     for (size_t i = 0; i < count; ++i) {
-      new (&dest[i]) value_type(std::move(first[i]));
-      first[i].~value_type();
+      new (&dest[i]) slot_type(std::move(first[i]));
+      first[i].~slot_type();
     }
   } else {
     for (size_t i = 0; i < count; ++i) {
-      new (&dest[i]) value_type(first[i]);
-      first[i].~value_type();
+      new (&dest[i]) slot_type(first[i]);
+      first[i].~slot_type();
     }
   }
 }
 
 template <typename Params>
-void WTreeNode<Params>::safe_move_backward_range(value_type *first,
-                                                 value_type *last,
-                                                 value_type *dest_last) {
+void WTreeNode<Params>::safe_move_backward_range(slot_type *first,
+                                                 slot_type *last,
+                                                 slot_type *dest_last) {
   const size_t count = last - first;
   if (count == 0)
     return;
 
-  value_type *dest_first = dest_last - count;
+  slot_type *dest_first = dest_last - count;
   assert(dest_last >= last);
 
   // No-op when source and destination are the same location.
@@ -332,51 +713,62 @@ void WTreeNode<Params>::safe_move_backward_range(value_type *first,
   const bool overlapping = !(dest_first >= last || dest_last <= first);
 
   if (!overlapping) {
-    if constexpr (std::is_move_constructible_v<value_type>) {
+    if constexpr (std::is_move_constructible_v<slot_type>) {
       for (size_t i = count; i > 0; --i) {
-        new (&dest_first[i - 1]) value_type(std::move(first[i - 1]));
-        first[i - 1].~value_type();
+        new (&dest_first[i - 1]) slot_type(std::move(first[i - 1]));
+        first[i - 1].~slot_type();
       }
     } else {
       for (size_t i = count; i > 0; --i) {
-        new (&dest_first[i - 1]) value_type(first[i - 1]);
-        first[i - 1].~value_type();
+        new (&dest_first[i - 1]) slot_type(first[i - 1]);
+        first[i - 1].~slot_type();
       }
     }
-  } else if constexpr (std::is_move_assignable_v<value_type>) {
+  } else if constexpr (std::is_trivially_copyable_v<slot_type>) {
     std::move_backward(first, last, dest_last);
-  } else if constexpr (std::is_move_constructible_v<value_type>) {
+  } else if constexpr (std::is_move_assignable_v<slot_type>) {
+    // The destination slots past the source range may not be alive.
+    for (size_t i = count; i > 0; --i) {
+      if (&dest_first[i - 1] >= last)
+        new (&dest_first[i - 1]) slot_type(std::move(first[i - 1]));
+      else
+        dest_first[i - 1] = std::move(first[i - 1]);
+    }
+    // The moved-out slots before the destination are left empty.
+    for (slot_type *p = first; p < dest_first; ++p)
+      p->~slot_type();
+  } else if constexpr (std::is_move_constructible_v<slot_type>) {
     for (size_t i = count; i > 0; --i) {
-      new (&dest_first[i - 1]) value_type(std::move(first[i - 1]));
-      first[i - 1].~value_type();
+      new (&dest_first[i - 1]) slot_type(std::move(first[i - 1]));
+      first[i - 1].~slot_type();
     }
   } else {
     for (size_t i = count; i > 0; --i) {
-      new (&dest_first[i - 1]) value_type(first[i - 1]);
-      first[i - 1].~value_type();
+      new (&dest_first[i - 1]) slot_type(first[i - 1]);
+      first[i - 1].~slot_type();
     }
   }
 }
 
 template <typename Params>
-void WTreeNode<Params>::reverse_range(value_type *first, value_type *last) {
-  if constexpr (std::is_move_assignable_v<value_type>) {
+void WTreeNode<Params>::reverse_range(slot_type *first, slot_type *last) {
+  if constexpr (std::is_move_assignable_v<slot_type>) {
     std::reverse(first, last);
   } else {
     // Manual reverse using move construction
     while (first != last && first != --last) {
       // Swap *first and *last using move construction
-      alignas(value_type) char temp_storage[sizeof(value_type)];
-      value_type *temp = reinterpret_cast<value_type *>(temp_storage);
+      alignas(slot_type) char temp_storage[sizeof(slot_type)];
+      slot_type *temp = reinterpret_cast<slot_type *>(temp_storage);
 
-      new (temp) value_type(std::move(*first));
-      first->~value_type();
+      new (temp) slot_type(std::move(*first));
+      first->~slot_type();
 
-      new (first) value_type(std::move(*last));
-      last->~value_type();
+      new (first) slot_type(std::move(*last));
+      last->~slot_type();
 
-      new (last) value_type(std::move(*temp));
-      temp->~value_type();
+      new (last) slot_type(std::move(*temp));
+      temp->~slot_type();
 
       ++first;
     }
@@ -384,9 +776,9 @@ void WTreeNode<Params>::reverse_range(value_type *first, value_type *last) {
 }
 
 template <typename Params>
-void WTreeNode<Params>::safe_rotate(value_type *first, value_type *middle,
-                                    value_type *last) {
-  if constexpr (std::is_move_assignable_v<value_type>) {
+void WTreeNode<Params>::safe_rotate(slot_type *first, slot_type *middle,
+                                    slot_type *last) {
+  if constexpr (std::is_move_assignable_v<slot_type>) {
     // Use standard rotate for move-assignable types
     std::rotate(first, middle, last);
   } else {
@@ -404,56 +796,56 @@ void WTreeNode<Params>::safe_rotate(value_type *first, value_type *middle,
     if (first_part_size == 1 && second_part_size == 1) {
       // Simple case: swap two elements
       // Create temporary storage
-      alignas(value_type) char temp_storage[sizeof(value_type)];
-      value_type *temp = reinterpret_cast<value_type *>(temp_storage);
+      alignas(slot_type) char temp_storage[sizeof(slot_type)];
+      slot_type *temp = reinterpret_cast<slot_type *>(temp_storage);
 
       // Move first element to temp
-      new (temp) value_type(std::move(*first));
-      first->~value_type();
+      new (temp) slot_type(std::move(*first));
+      first->~slot_type();
 
       // Move second element to first position
-      new (first) value_type(std::move(*middle));
-      middle->~value_type();
+      new (first) slot_type(std::move(*middle));
+      middle->~slot_type();
 
       // Move temp to second position
-      new (middle) value_type(std::move(*temp));
-      temp->~value_type();
+      new (middle) slot_type(std::move(*temp));
+      temp->~slot_type();
 
     } else if (first_part_size == 1) {
       // Rotating one element to the right
       // Save the first element
-      alignas(value_type) char temp_storage[sizeof(value_type)];
-      value_type *temp = reinterpret_cast<value_type *>(temp_storage);
-      new (temp) value_type(std::move(*first));
-      first->~value_type();
+      alignas(slot_type) char temp_storage[sizeof(slot_type)];
+      slot_type *temp = reinterpret_cast<slot_type *>(temp_storage);
+      new (temp) slot_type(std::move(*first));
+      first->~slot_type();
 
       // Shift all elements in [middle, last) one position left
-      for (value_type *it = first; it != last - 1; ++it) {
-        new (it) value_type(std::move(*(it + 1)));
-        (it + 1)->~value_type();
+      for (slot_type *it = first; it != last - 1; ++it) {
+        new (it) slot_type(std::move(*(it + 1)));
+        (it + 1)->~slot_type();
       }
 
       // Place the saved element at the end
-      new (last - 1) value_type(std::move(*temp));
-      temp->~value_type();
+      new (last - 1) slot_type(std::move(*temp));
+      temp->~slot_type();
 
     } else if (second_part_size == 1) {
       // Rotating one element to the left
       // Save the middle element
-      alignas(value_type) char temp_storage[sizeof(value_type)];
-      value_type *temp = reinterpret_cast<value_type *>(temp_storage);
-      new (temp) value_type(std::move(*middle));
-      middle->~value_type();
+      alignas(slot_type) char temp_storage[sizeof(slot_type)];
+      slot_type *temp = reinterpret_cast<slot_type *>(temp_storage);
+      new (temp) slot_type(std::move(*middle));
+      middle->~slot_type();
 
       // Shift all elements in [first, middle) one position right
-      for (value_type *it = middle - 1; it != first - 1; --it) {
-        new (it + 1) value_type(std::move(*it));
-        it->~value_type();
+      for (slot_type *it = middle - 1; it != first - 1; --it) {
+        new (it + 1) slot_type(std::move(*it));
+        it->~slot_type();
       }
 
       // Place the saved element at the beginning
-      new (first) value_type(std::move(*temp));
-      temp->~value_type();
+      new (first) slot_type(std::move(*temp));
+      temp->~slot_type();
 
     } else {
       reverse_range(first, middle);
@@ -1,10 +1,12 @@
 #ifndef _WTREE_MANAGER__H_
 #define _WTREE_MANAGER__H_
 
+#include "node_pool.hpp"
 #include "traits.hpp"
 #include "type_aliases.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -47,6 +49,7 @@ public:
   using typename Aliases::reverse_iterator;
   using typename Aliases::size_type;
   using typename Aliases::value_type;
+  using typename Aliases::slot_type;
 
   using Aliases::kBasefieldsBytes;
   using Aliases::kInitialCapacity;
@@ -78,9 +81,73 @@ public:
   WTreeNodeManager(const internal_allocator_type &alloc)
       : m_root(alloc, nullptr), m_size(0) {}
 
+  WTreeNodeManager(WTreeNodeManager &&) noexcept = default;
+
+  ~WTreeNodeManager() {
+    if constexpr (kUseNodePool)
+      m_pool.release(mutable_allocator());
+  }
+
+  // Capacity a leaf grows to from the given one.
+  static constexpr field_type next_leaf_capacity(field_type capacity) {
+    if (capacity == 1)
+      return 2;
+    if constexpr (std::is_same_v<field_type, uint8_t>)
+      return std::min<field_type>(
+          SAFE_NEW_SIZE(capacity, kLastGrowth, kTargetK), kTargetK);
+    else
+      return std::min<field_type>(NEW_SIZE(capacity), kTargetK);
+  }
+
+  // Nodes come from a slab allocator (see WTREE_NODE_SLAB_BYTES) with a
+  // size class per leaf capacity that grow_leaf goes through, from
+  // kInitialCapacity to kTargetK, plus one for internal nodes. Leaves get
+  // the capacity of their class.
+  static constexpr bool kUseNodePool = WTREE_NODE_SLAB_BYTES > 0;
+
+  static constexpr size_t count_leaf_classes() {
+    size_t count = 1;
+    for (field_type c = std::min<field_type>(kInitialCapacity, kTargetK);
+         c < kTargetK; c = next_leaf_capacity(c))
+      ++count;
+    return count;
+  }
+  static constexpr size_t kLeafClasses = count_leaf_classes();
+  static constexpr size_t kInternalClass = kLeafClasses;
+
+  static constexpr std::array<field_type, kLeafClasses> kLeafClassCapacities =
+      [] {
+        std::array<field_type, kLeafClasses> capacities{};
+        field_type c = std::min<field_type>(kInitialCapacity, kTargetK);
+        for (size_t i = 0; i < kLeafClasses; ++i) {
+          capacities[i] = c;
+          c = next_leaf_capacity(c);
+        }
+        return capacities;
+      }();
+
+  // Size class of the leaves with the given capacity, the first class with
+  // room for it.
+  static size_t leaf_class(field_type capacity) {
+    return std::lower_bound(kLeafClassCapacities.begin(),
+                            kLeafClassCapacities.end(), capacity) -
+           kLeafClassCapacities.begin();
+  }
+
+  // Slabs come from huge-page regions with kUseHugePages (see
+  // WTREE_NODE_HUGE_PAGES), and from the span child handles refer to with
+  // kUseChildHandles.
+  using node_pool_type =
+      WTreeNodePool<internal_allocator_type,
+                    kUseNodePool ? kLeafClasses + 1 : 0, WTREE_NODE_SLAB_BYTES,
+                    params_type::kUseHugePages, node_type::kUseChildHandles>;
+  static_assert(!node_type::kUseChildHandles || kUseNodePool,
+                "Child handles need node slabs (WTREE_NODE_SLAB_BYTES).");
+
 protected:
   EmptyBaseNodeHandle<internal_allocator_type, node_type *> m_root;
   size_type m_size = 0;
+  node_pool_type m_pool;
 
   // Internal accessor routines.
   node_type *root() { return m_root.data; }
@@ -110,20 +177,49 @@ public:
   const internal_allocator_type &internal_allocator() const noexcept {
     return *static_cast<const internal_allocator_type *>(&m_root);
   }
+  const node_pool_type &node_pool() const noexcept { return m_pool; }
+
+  // Root of the trees without values: a leaf without room for any, shared
+  // by every tree of these params and never written, so that empty trees
+  // own no node. The first insert replaces it with a leaf of the tree's
+  // own, which becomes an internal node once full.
+  static node_type *empty_root() {
+    alignas(node_type) static char bytes[node_type::leaf_bytes(0)] = {};
+    return reinterpret_cast<node_type *>(bytes);
+  }
+  static bool is_empty_root(const node_type *node) {
+    return node == empty_root();
+  }
 
   node_type *new_leaf_node(field_type capacity) {
     internal_allocator_type &ia = mutable_allocator();
     leaf_fields_type *u;
-    const int nbytes = kBasefieldsBytes + (sizeof(value_type) * capacity);
-    u = reinterpret_cast<leaf_fields_type *>(
-        internal_allocator_traits::allocate(ia, nbytes));
+    if constexpr (kUseNodePool) {
+      const size_t cls = leaf_class(capacity);
+      capacity = kLeafClassCapacities[cls];
+      u = static_cast<leaf_fields_type *>(m_pool.allocate(
+          ia, cls,
+          node_pool_type::round_bytes(node_type::leaf_bytes(capacity))));
+    } else {
+      const int nbytes = node_type::leaf_bytes(capacity);
+      u = reinterpret_cast<leaf_fields_type *>(
+          internal_allocator_traits::allocate(ia, nbytes));
+    }
     return init_leaf(u, capacity);
   }
 
   node_type *new_internal_node() {
     internal_allocator_type &ia = mutable_allocator();
-    internal_fields_type *u = reinterpret_cast<internal_fields_type *>(
-        internal_allocator_traits::allocate(ia, sizeof(internal_fields_type)));
+    internal_fields_type *u;
+    if constexpr (kUseNodePool) {
+      u = static_cast<internal_fields_type *>(m_pool.allocate(
+          ia, kInternalClass,
+          node_pool_type::round_bytes(sizeof(internal_fields_type))));
+    } else {
+      u = reinterpret_cast<internal_fields_type *>(
+          internal_allocator_traits::allocate(ia,
+                                              sizeof(internal_fields_type)));
+    }
     return init_internal(u);
   }
 
@@ -137,9 +233,10 @@ public:
     // We could lazy init values:
 #ifndef NDEBUG
     void *res =
-        memset(&node->fields.values, 0, init_capacity * sizeof(value_type));
+        memset(&node->fields.values, 0, init_capacity * sizeof(slot_type));
     assert(res != nullptr);
 #endif
+    node->reset_search_layout();
     return node;
   }
 
@@ -152,12 +249,15 @@ public:
     void *res;
     // We could lazy init values:
 #ifndef NDEBUG
-    res = memset(&node->fields.values, 0, kTargetK * sizeof(value_type));
+    res = memset(&node->fields.values, 0, kTargetK * sizeof(slot_type));
     assert(res != nullptr);
 #endif
 
-    res = memset(node->fields.pointers, 0, sizeof(node->fields.pointers));
-    assert(res != nullptr);
+    node->clear_children();
+    assert(!node_type::kUseKeyColumn ||
+           static_cast<void *>(node->key_column()) ==
+               static_cast<void *>(&node->fields.key_column));
+    node->reset_search_layout();
     return node;
   }
 
@@ -166,25 +266,20 @@ public:
   node_type *grow_leaf(node_type *node) {
     assert(node->capacity() < kTargetK);
 
-    field_type new_capacity;
-    if (node->capacity() == 1) {
-      new_capacity = 2;
-    } else if constexpr (std::is_same_v<field_type, uint8_t>) {
-      new_capacity = SAFE_NEW_SIZE(node->capacity(), kLastGrowth, kTargetK);
-    } else {
-      new_capacity = std::min<field_type>(NEW_SIZE(node->capacity()), kTargetK);
-    }
+    const field_type new_capacity = next_leaf_capacity(node->capacity());
     assert(new_capacity > node->capacity());
 
     node_type *new_node = new_leaf_node(new_capacity);
-    if constexpr (std::is_trivially_copyable_v<value_type>) {
+    if constexpr (std::is_trivially_copyable_v<slot_type>) {
       std::memcpy(static_cast<void *>(new_node->fields.values),
                   static_cast<const void *>(node->fields.values),
-                  node->size() * sizeof(value_type));
+                  node->size() * sizeof(slot_type));
+      node_type::copy_search_keys(node, 0, node->size(), new_node, 0);
     } else {
       move_values_to_node(node, new_node, node->size());
     }
     new_node->fields.size = node->size();
+    new_node->refresh_search_layout();
     delete_leaf_node(node);
     return new_node;
   }
@@ -222,6 +317,7 @@ public:
     // Copy values using the appropriate method
     move_values_to_node(node, new_node, node->size());
     new_node->fields.size = node->size();
+    new_node->refresh_search_layout();
 
     delete_leaf_node(node);
     return new_node;
@@ -238,6 +334,7 @@ public:
 
     move_values_to_node(node, new_node, node->size());
     new_node->fields.size = node->size();
+    new_node->refresh_search_layout();
 
     delete_leaf_node(node);
     return new_node;
@@ -253,6 +350,7 @@ public:
     // Copy values using the appropriate method
     move_values_to_node(node, leaf, node->size());
     leaf->fields.size = node->size();
+    leaf->refresh_search_layout();
 
     delete_internal_node(node);
     return leaf;
@@ -261,7 +359,7 @@ public:
   inline void make_child_internal_unchecked(node_type *parent, field_type i) {
     assert(parent->is_internal());
     assert(parent->child(i)->is_leaf());
-    parent->fields.pointers[i] = make_internal(parent->child(i));
+    parent->set_child(i, make_internal(parent->child(i)));
   }
 
   inline void make_child_leaf_unchecked(node_type *parent, field_type i) {
@@ -271,27 +369,32 @@ public:
   }
 
   inline void delete_leaf_node(node_type *&node) {
-    internal_allocator_type &ia = mutable_allocator();
-    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+    if constexpr (!std::is_trivially_destructible_v<slot_type>) {
       for (field_type i = 0; i < node->size(); ++i) {
         node->destroy_value(i);
       }
     }
-    const size_t node_size =
-        kBasefieldsBytes + (node->capacity() * sizeof(value_type));
-    internal_allocator_traits::deallocate(ia, reinterpret_cast<char *>(node),
-                                          node_size);
+    if constexpr (kUseNodePool) {
+      m_pool.deallocate(leaf_class(node->capacity()), node);
+    } else {
+      const size_t node_size = node_type::leaf_bytes(node->capacity());
+      internal_allocator_traits::deallocate(
+          mutable_allocator(), reinterpret_cast<char *>(node), node_size);
+    }
   }
 
   inline void delete_internal_node(node_type *&node) {
-    internal_allocator_type &ia = mutable_allocator();
-    if constexpr (!std::is_trivially_destructible_v<value_type>) {
+    if constexpr (!std::is_trivially_destructible_v<slot_type>) {
       for (field_type i = 0; i < node->size(); ++i) {
         node->destroy_value(i);
       }
     }
-    internal_allocator_traits::deallocate(ia, reinterpret_cast<char *>(node),
-                                          sizeof(internal_fields_type));
+    if constexpr (kUseNodePool)
+      m_pool.deallocate(kInternalClass, node);
+    else
+      internal_allocator_traits::deallocate(mutable_allocator(),
+                                            reinterpret_cast<char *>(node),
+                                            sizeof(internal_fields_type));
   }
 
   void internal_destroy_child_unchecked(node_type *parent, field_type index) {
@@ -308,6 +411,87 @@ public:
     parent->set_child(index, nullptr);
   }
 
+  // With nothing to destroy in the nodes, whole trees are freed by giving
+  // back their slabs, without visiting their nodes.
+  static constexpr bool kDeleteInBulk =
+      kUseNodePool && std::is_trivially_destructible_v<slot_type>;
+
+  // Deletes the tree under root, root included.
+  void delete_tree(node_type *root) {
+    if constexpr (kDeleteInBulk)
+      m_pool.release(mutable_allocator());
+    else if (!is_empty_root(root))
+      internal_recursive_delete(root);
+  }
+
+  // Moves the tree under root to new nodes laid out depth-first, every node
+  // right before its subtrees, with leaves of the least capacity that holds
+  // their values, and returns the new root. With node slabs, the new nodes
+  // are carved in that order from fresh slabs and the old ones are
+  // returned. A tree without values is left with the empty root.
+  node_type *compact_tree(node_type *root) {
+    if (root->size() == 0) {
+      delete_tree(root);
+      return empty_root();
+    }
+    if constexpr (kUseNodePool) {
+      node_pool_type old_pool(std::move(m_pool));
+      m_pool.reserve_run(mutable_allocator(), compacted_bytes(root));
+      node_type *compacted = move_subtree(root);
+      old_pool.release(mutable_allocator());
+      return compacted;
+    } else {
+      return move_subtree(root);
+    }
+  }
+
+  static field_type compacted_capacity(const node_type *leaf) {
+    const field_type capacity = std::max<field_type>(leaf->size(), 1);
+    if constexpr (kUseNodePool)
+      return kLeafClassCapacities[leaf_class(capacity)];
+    else
+      return capacity;
+  }
+
+  // Bytes the nodes under u take once compacted.
+  static size_t compacted_bytes(const node_type *u) {
+    if (u->is_leaf())
+      return node_pool_type::round_bytes(
+          node_type::leaf_bytes(compacted_capacity(u)));
+    size_t bytes = node_pool_type::round_bytes(sizeof(internal_fields_type));
+    for (field_type i = 0; i < kTargetK - 1; ++i)
+      if (u->child(i) != nullptr)
+        bytes += compacted_bytes(u->child(i));
+    return bytes;
+  }
+
+  node_type *move_subtree(node_type *src) {
+    node_type *dest;
+    if (src->is_internal()) {
+      dest = new_internal_node();
+      for (field_type i = src->first_right_descendant(field_type(0));
+           i < kTargetK - 1; i = src->first_right_descendant(field_type(i + 1)))
+        dest->set_child(i, move_subtree(src->child(i)));
+    } else {
+      dest = new_leaf_node(compacted_capacity(src));
+    }
+    move_values_to_node(src, dest, src->size());
+    dest->fields.size = src->size();
+    dest->refresh_search_layout();
+
+    // The old slabs go back at once: only what src holds is left to free.
+    if constexpr (kUseNodePool) {
+      if constexpr (!std::is_trivially_destructible_v<slot_type>)
+        for (field_type i = 0; i < src->size(); ++i)
+          src->destroy_value(i);
+    } else if (src->is_internal()) {
+      delete_internal_node(src);
+    } else {
+      delete_leaf_node(src);
+    }
+    return dest;
+  }
+
   // Erase the tree visiting childrens recursively.
   void internal_recursive_delete(node_type *u) {
     if (u == nullptr) {
@@ -329,17 +513,18 @@ public:
   // Note: This function moves/destroys source values.
   void move_values_to_node(node_type *src, node_type *dest, field_type count,
                            field_type dest_offset = 0) {
-    if constexpr (std::is_trivially_copyable_v<value_type>) {
+    if constexpr (std::is_trivially_copyable_v<slot_type>) {
       std::memcpy(static_cast<void *>(dest->fields.values + dest_offset),
                   static_cast<void *>(src->fields.values),
-                  count * sizeof(value_type));
-    } else if constexpr (std::is_move_constructible_v<value_type>) {
+                  count * sizeof(slot_type));
+    } else if constexpr (std::is_move_constructible_v<slot_type>) {
       std::uninitialized_move_n(src->fields.values, count,
                                 dest->fields.values + dest_offset);
     } else {
       std::uninitialized_copy_n(src->fields.values, count,
                                 dest->fields.values + dest_offset);
     }
+    node_type::copy_search_keys(src, 0, count, dest, dest_offset);
   }
 
   /**
@@ -356,6 +541,7 @@ public:
   inline IterType internal_emplace_at(IterType &hint, Args &&...args) {
     hint.node->internal_emplace_as_leaf(hint.index,
                                         std::forward<Args>(args)...);
+    hint.node->refresh_search_layout();
     increment_size();
     return hint;
   }
@@ -374,11 +560,11 @@ public:
     assert(it.node->size() < kTargetK);
 
     if (it.node->size() == it.node->capacity()) {
-      // Root never grows.
-      assert(it.has_ascendant());
-
       it.node = grow_leaf(it.node);
-      it.ascendant()->set_child(it.position(), it.node);
+      if (it.has_ascendant())
+        it.ascendant()->set_child(it.position(), it.node);
+      else
+        mutable_root() = it.node;
     }
     return internal_emplace_at(it, std::forward<Args>(args)...);
   }
@@ -403,7 +589,6 @@ public:
     node_type *p = it.ascendant();
     const field_type pi = it.position();
     node_type *sibling = p->child(pi + 1);
-    auto *const node_vals = it.node->fields.values;
 
     const field_type mid = (kTargetK >> 1) + (sibling->size() >> 1) + 1;
     const field_type sib_newsize = kTargetK - (mid - 1) + sibling->size();
@@ -415,6 +600,8 @@ public:
     p->move_value(pi + 1, sibling, kTargetK - mid);
     sibling->fields.size = sib_newsize;
     it.node->fields.size = mid;
+    sibling->reset_search_layout();
+    it.node->reset_search_layout();
 
     // Easy case that keeps it.node untouch.
     // Only one key is moved.
@@ -428,8 +615,7 @@ public:
     if (it.index == mid) {
       // Key becomes the new parent pivot.
       p->construct_value(pi + 1, std::forward<Args>(args)...);
-      node_type::safe_move_range(node_vals + mid, node_vals + kTargetK,
-                                 sibling->fields.values);
+      node_type::move_values(it.node, mid, kTargetK, sibling, 0);
       it.ascend();
       ++it.index;
       assert(it.index == pi + 1);
@@ -440,12 +626,10 @@ public:
       // Key goes to right sibling v.
       // p[pi+1] gets u[right] (insertion past the split, no shift in u).
       it.node->move_value(mid, p, pi + 1);
-      node_type::safe_move_range(node_vals + mid + 1, node_vals + it.index,
-                                 sibling->fields.values);
+      node_type::move_values(it.node, mid + 1, it.index, sibling, 0);
       const field_type newpos = it.index - mid - 1;
       sibling->construct_value(newpos, std::forward<Args>(args)...);
-      node_type::safe_move_range(node_vals + it.index, node_vals + kTargetK,
-                                 sibling->fields.values + newpos + 1);
+      node_type::move_values(it.node, it.index, kTargetK, sibling, newpos + 1);
       it.ascend();
       it.descend(pi + 1);
       it.index = newpos;
@@ -454,8 +638,7 @@ public:
 
     // Key stays in u (it.index < mid).
     // Pivot = u[mid-1] (insertion shifts logical positions mid).
-    node_type::safe_move_range(node_vals + mid, node_vals + kTargetK,
-                               sibling->fields.values);
+    node_type::move_values(it.node, mid, kTargetK, sibling, 0);
     it.node->move_value(mid - 1, p, pi + 1);
     --it.node->fields.size;
     it.node->internal_emplace_as_leaf(it.index, std::forward<Args>(args)...);
@@ -480,7 +663,6 @@ public:
     node_type *p = it.ascendant();
     const field_type pi = it.position();
     node_type *sibling = p->child(pi - 1);
-    auto *const node_vals = it.node->fields.values;
 
     // Node must remain with this size:
     const field_type target_size = (kTargetK >> 1) + (sibling->size() >> 1) + 1;
@@ -491,8 +673,10 @@ public:
     // Prepare left sibling: grow, append old parent pivot to end.
     // No shift needed — existing values stay at [0, sib_old_size).
     sibling = grow_leaf_to_size(sibling, sib_old_size + mid + 1);
-    p->fields.pointers[pi - 1] = sibling;
+    p->set_child(pi - 1, sibling);
     p->move_value(pi, sibling, sib_old_size);
+    sibling->reset_search_layout();
+    it.node->reset_search_layout();
 
     // Easy case that keeps it.node untouch.
     // Only one key is moved.
@@ -505,12 +689,10 @@ public:
 
     if (it.index == mid) {
       // Key becomes the new parent pivot.
-      node_type::safe_move_range(node_vals, node_vals + mid,
-                                 sibling->fields.values + sib_old_size + 1);
+      node_type::move_values(it.node, 0, mid, sibling, sib_old_size + 1);
       sibling->fields.size = sib_old_size + mid + 1;
 
-      node_type::safe_move_range(node_vals + mid, node_vals + kTargetK,
-                                 node_vals);
+      node_type::move_values(it.node, mid, kTargetK, it.node, 0);
       it.node->fields.size = kTargetK - mid;
 
       p->construct_value(pi, std::forward<Args>(args)...);
@@ -522,16 +704,13 @@ public:
     if (it.index < mid) {
       // Key goes to left sibling v.
       // Elements for v: u[0..idx-1], key, u[idx..mid-2]. Pivot = u[mid-1].
-      node_type::safe_move_range(node_vals, node_vals + it.index,
-                                 sibling->fields.values + sib_old_size + 1);
+      node_type::move_values(it.node, 0, it.index, sibling, sib_old_size + 1);
       const field_type newidx = sib_old_size + 1 + it.index;
-      node_type::safe_move_range(node_vals + it.index, node_vals + mid - 1,
-                                 sibling->fields.values + newidx + 1);
+      node_type::move_values(it.node, it.index, mid - 1, sibling, newidx + 1);
       sibling->construct_value(newidx, std::forward<Args>(args)...);
 
       it.node->move_value(mid - 1, p, pi);
-      node_type::safe_move_range(node_vals + mid, node_vals + kTargetK,
-                                 node_vals);
+      node_type::move_values(it.node, mid, kTargetK, it.node, 0);
       sibling->fields.size = sib_old_size + 1 + mid;
       it.node->fields.size = target_size;
       it.ascend();
@@ -542,16 +721,14 @@ public:
 
     // Key stays in u (it.index > mid).
     // Elements for v: u[0..mid-1]. Pivot = u[mid].
-    node_type::safe_move_range(node_vals, node_vals + mid,
-                               sibling->fields.values + sib_old_size + 1);
+    node_type::move_values(it.node, 0, mid, sibling, sib_old_size + 1);
     it.node->move_value(mid, p, pi);
 
     // Shift elements u[mid+1..kTargetK-1] and create key:
-    node_type::safe_move_range(node_vals + mid + 1, node_vals + it.index,
-                               node_vals);
+    node_type::move_values(it.node, mid + 1, it.index, it.node, 0);
     it.node->construct_value(it.index - mid - 1, std::forward<Args>(args)...);
-    node_type::safe_move_range(node_vals + it.index, node_vals + kTargetK,
-                               node_vals + it.index - mid);
+    node_type::move_values(it.node, it.index, kTargetK, it.node,
+                           it.index - mid);
     it.index -= mid + 1;
     it.node->fields.size = target_size;
     sibling->fields.size = sib_old_size + mid + 1;
@@ -572,20 +749,28 @@ public:
     assert(it.node->is_leaf());
     assert(it.has_ascendant());
 
-    const node_type *p = it.ascendant();
+    node_type *p = it.ascendant();
     assert(p->is_internal());
 
     const field_type pi = it.position();
-
+    field_type sibling;
     if (pi < kTargetK - 2 && p->child(pi + 1) != nullptr &&
-        p->child(pi + 1)->size() < kTargetK)
-      return internal_balanced_slide_to_right(it, std::forward<Args>(args)...);
-
-    if (pi > 0 && p->child(pi - 1) != nullptr &&
-        p->child(pi - 1)->size() < kTargetK)
-      return internal_balanced_slide_to_left(it, std::forward<Args>(args)...);
+        p->child(pi + 1)->size() < kTargetK) {
+      internal_balanced_slide_to_right(it, std::forward<Args>(args)...);
+      sibling = pi + 1;
+    } else if (pi > 0 && p->child(pi - 1) != nullptr &&
+               p->child(pi - 1)->size() < kTargetK) {
+      internal_balanced_slide_to_left(it, std::forward<Args>(args)...);
+      sibling = pi - 1;
+    } else {
+      return false;
+    }
 
-    return false;
+    // The slide moved values across the leaf, its sibling and the parent.
+    p->child(pi)->refresh_search_layout();
+    p->child(sibling)->refresh_search_layout();
+    p->refresh_search_layout();
+    return true;
   }
 
   // Handles insertion at the edge of a full internal node (index == 0 or
@@ -656,6 +841,7 @@ public:
           it.node->set_child(child_idx, leaf);
           it.node->move_value(swap_idx, leaf, 0);
           leaf->fields.size = 1;
+          leaf->refresh_search_layout();
         }
       }
 
@@ -666,17 +852,20 @@ public:
       it.node->set_child(child_idx, leaf);
       it.node->move_value(swap_idx, leaf, 0);
       leaf->fields.size = 1;
+      leaf->refresh_search_layout();
     }
 
     // Phase 3: Pull keys down through intermediate levels.
     for (; levels > 0; --levels) {
       node_type *parent = it.ascendant();
       parent->move_value(swap_idx, it.node, swap_idx);
+      it.node->refresh_search_layout();
       it.ascend();
     }
 
     // Phase 4: Construct the original value at the top.
     it.node->construct_value(swap_idx, std::forward<Args>(args)...);
+    it.node->refresh_search_layout();
     it.index = swap_idx;
     increment_size();
     return it;
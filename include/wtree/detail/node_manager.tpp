@@ -10,6 +10,8 @@ void WTreeNodeManager<Params>::internal_move_greatest_upward(iterator &iter) {
 
   if (!iter.has_ascendant()) {
     --iter.node->fields.size;
+    iter.node->invalidate_search_layout();
+    iter.node->refresh_search_layout();
     // Note that [iter.node] may be empty, and must be destroyed
     // from outside this function.
     return;
@@ -18,28 +20,30 @@ void WTreeNodeManager<Params>::internal_move_greatest_upward(iterator &iter) {
   for (; level < iter.path_size() - 1; ++level) {
     node_type *node = iter.ascendants[level];
     const field_type pos = iter.move_indexes[level];
-    node_type::safe_move_backward_range(node->fields.values + pos + 1,
-                                        node->fields.values + kTargetK - 1,
-                                        node->fields.values + kTargetK);
+    node_type::move_values_backward(node, pos + 1, kTargetK - 1, node,
+                                    kTargetK);
 
     iter.ascendants[level + 1]->move_value(
         iter.ascendants[level + 1]->size() - 1, node, pos + 1);
+    node->refresh_search_layout();
   }
   assert(iter.node != root());
   assert(iter.node->is_leaf());
 
-  node_type::safe_move_backward_range(
-      iter.ascendant()->fields.values + iter.position() + 1,
-      iter.ascendant()->fields.values + kTargetK - 1,
-      iter.ascendant()->fields.values + kTargetK);
+  node_type::move_values_backward(iter.ascendant(), iter.position() + 1,
+                                  kTargetK - 1, iter.ascendant(), kTargetK);
   iter.node->move_value(iter.node->size() - 1, iter.ascendant(),
                         iter.position() + 1);
+  iter.ascendant()->refresh_search_layout();
   if (iter.node->size() == 1) {
+    // The only value was already moved out; do not destroy it twice.
+    --iter.node->fields.size;
     internal_destroy_child_unchecked(iter.ascendant(), iter.position());
     iter.ascend();
     return;
   }
   --iter.node->fields.size;
+  iter.node->refresh_search_layout();
 }
 
 template <typename Params>
@@ -48,10 +52,10 @@ void WTreeNodeManager<Params>::internal_move_smallest_upward(iterator &iter) {
 
   if (!iter.has_ascendant()) {
     // Shift elements left by 1: [1, size+1) -> [0, size)
-    node_type::safe_move_range(iter.node->fields.values + 1,
-                               iter.node->fields.values + iter.node->size(),
-                               iter.node->fields.values);
+    node_type::move_values(iter.node, 1, iter.node->size(), iter.node, 0);
     --iter.node->fields.size;
+    iter.node->invalidate_search_layout();
+    iter.node->refresh_search_layout();
     // Note that [iter.node] may be empty, and must be destroyed
     // from outside this functions.
     return;
@@ -61,29 +65,29 @@ void WTreeNodeManager<Params>::internal_move_smallest_upward(iterator &iter) {
     node_type *node = iter.ascendants[level];
     const field_type pos = iter.move_indexes[level];
     // Shift elements left by 1: [1, pos+1) -> [0, pos)
-    node_type::safe_move_range(node->fields.values + 1,
-                               node->fields.values + pos + 1,
-                               node->fields.values);
+    node_type::move_values(node, 1, pos + 1, node, 0);
 
     iter.ascendants[level + 1]->move_value(0, node, pos);
+    node->refresh_search_layout();
   }
   assert(iter.node != root());
   assert(iter.node->is_leaf());
 
-  node_type::safe_move_range(iter.ascendant()->fields.values + 1,
-                             iter.ascendant()->fields.values + iter.position() +
-                                 1,
-                             iter.ascendant()->fields.values);
+  node_type::move_values(iter.ascendant(), 1, iter.position() + 1,
+                         iter.ascendant(), 0);
   iter.node->move_value(0, iter.ascendant(), iter.position());
+  iter.ascendant()->refresh_search_layout();
   if (iter.node->size() == 1) {
+    // The only value was already moved out; do not destroy it twice.
+    --iter.node->fields.size;
     internal_destroy_child_unchecked(iter.ascendant(), iter.position());
     iter.ascend();
     return;
   }
-  node_type::safe_move_range(iter.node->fields.values + 1,
-                             iter.node->fields.values + iter.node->size(),
-                             iter.node->fields.values);
+  node_type::move_values(iter.node, 1, iter.node->size(), iter.node, 0);
   --iter.node->fields.size;
+  iter.node->invalidate_search_layout();
+  iter.node->refresh_search_layout();
 }
 
 template <class Params>
@@ -94,9 +98,7 @@ WTreeNodeManager<Params>::grow_leaf_and_shift_right(node_type *node,
 
   if (new_size <= node->capacity()) {
     // No reallocation: shift in-place.
-    node_type::safe_move_backward_range(node->fields.values,
-                                        node->fields.values + old_size,
-                                        node->fields.values + new_size);
+    node_type::move_values_backward(node, 0, old_size, node, new_size);
     return node;
   }
 
@@ -0,0 +1,260 @@
+#ifndef _WTREE_NODE_POOL__H_
+#define _WTREE_NODE_POOL__H_
+
+#include "handle_arena.hpp"
+#include "huge_page_arena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace WTreeLib {
+
+/**
+ * Slab allocator of tree nodes with one free list per size class, used by
+ * WTreeNodeManager (see WTREE_NODE_SLAB_BYTES).
+ *
+ * Nodes of a class are carved out of slabs obtained from Alloc (a char
+ * allocator). The slabs of a class hold 1, 2, 4... nodes, up to SlabBytes,
+ * so that small trees stay small. Freed nodes go to the free list of their
+ * class and are handed out again first; slabs only go back to Alloc on
+ * release() or release_except(), which free all the nodes at once. So a
+ * tree keeps the slabs of its largest size through erases, until it is
+ * cleared, destroyed or shrunk with shrink_to_fit().
+ *
+ * The free lists and slab chain live in a state allocated from Alloc with
+ * the first node and freed by release(), so the pool itself is a pointer.
+ *
+ * After reserve_run(bytes), the next bytes of nodes allocated, of any
+ * class, are carved one after the other in the order they are allocated,
+ * e.g. to lay a tree out in the order it is traversed.
+ *
+ * With HugePages, slabs come from a WTreeHugePageArena instead, and only
+ * fall back to Alloc when the arena cannot map more regions. With Handles,
+ * they all come from a WTreeHandleArena, carved from the span shared by
+ * all such pools, so that nodes can refer to each other by handles.
+ */
+template <typename Alloc, size_t Classes, size_t SlabBytes,
+          bool HugePages = false, bool Handles = false>
+class WTreeNodePool {
+  using allocator_traits = std::allocator_traits<Alloc>;
+
+  // Slabs are chained through a header at their start.
+  struct slab_header {
+    slab_header *next;
+    size_t bytes;
+    uint32_t cls;
+    uint32_t node_bytes;
+    bool uniform; // Whether all its nodes are of class cls (not a run).
+    bool mapped;  // Whether it comes from the arena.
+  };
+
+  struct no_arena {
+    void swap(no_arena &) noexcept {}
+  };
+  using arena_type = std::conditional_t<
+      Handles, WTreeHandleArena<HugePages>,
+      std::conditional_t<HugePages, WTreeHugePageArena, no_arena>>;
+
+  struct size_class {
+    void *free = nullptr;   // Freed nodes, chained through their first bytes.
+    char *cursor = nullptr; // Start of the unused part of the last slab.
+    slab_header *slab = nullptr; // Last slab.
+    size_t slab_nodes = 1;       // Nodes of the next slab.
+  };
+
+  struct pool_state {
+    std::array<size_class, Classes> classes{};
+    slab_header *slabs = nullptr;
+    char *run = nullptr;     // Start of the unused part of the run slab.
+    char *run_end = nullptr; // End of the run slab.
+    size_t run_left = 0;     // Bytes of the run still to be carved.
+  };
+  using state_allocator_type =
+      typename allocator_traits::template rebind_alloc<pool_state>;
+  using state_allocator_traits = std::allocator_traits<state_allocator_type>;
+
+public:
+  // Node sizes are rounded to keep nodes aligned as Alloc would.
+  static constexpr size_t kAlign = alignof(std::max_align_t);
+  static constexpr size_t round_bytes(size_t bytes) {
+    return (bytes + kAlign - 1) / kAlign * kAlign;
+  }
+
+  WTreeNodePool() = default;
+  WTreeNodePool(WTreeNodePool &&other) noexcept
+      : m_state(std::exchange(other.m_state, nullptr)),
+        m_arena(std::move(other.m_arena)) {}
+  WTreeNodePool(const WTreeNodePool &) = delete;
+  WTreeNodePool &operator=(const WTreeNodePool &) = delete;
+
+  // A node of class cls, whose nodes take bytes (rounded) each.
+  void *allocate(Alloc &alloc, size_t cls, size_t bytes) {
+    pool_state &st = state(alloc);
+    size_class &c = st.classes[cls];
+    if (c.free != nullptr) {
+      void *node = c.free;
+      c.free = *static_cast<void **>(node);
+      return node;
+    }
+    if (st.run_left >= bytes) {
+      if (static_cast<size_t>(st.run_end - st.run) < bytes)
+        add_run_slab(alloc, bytes);
+      void *node = st.run;
+      st.run += bytes;
+      st.run_left -= bytes;
+      return node;
+    }
+    if (c.slab == nullptr || unused_bytes(c) < bytes)
+      add_slab(alloc, c, cls, bytes);
+    void *node = c.cursor;
+    c.cursor += bytes;
+    return node;
+  }
+
+  void deallocate(size_t cls, void *node) {
+    size_class &c = m_state->classes[cls];
+    *static_cast<void **>(node) = c.free;
+    c.free = node;
+  }
+
+  // The next bytes of nodes allocated (when their free list is empty) are
+  // carved in sequence from as few slabs as possible.
+  void reserve_run(Alloc &alloc, size_t bytes) {
+    pool_state &st = state(alloc);
+    st.run = st.run_end = nullptr;
+    st.run_left = bytes;
+  }
+
+  // Returns every slab to alloc, which frees all the nodes.
+  void release(Alloc &alloc) { release_except(alloc, nullptr); }
+
+  // Frees all the nodes but kept: returns every slab to alloc except the
+  // one holding kept, whose other nodes go back to their free list (unless
+  // it is a run slab, with nodes of mixed classes).
+  void release_except(Alloc &alloc, const void *kept) {
+    if (m_state == nullptr)
+      return;
+    slab_header *kept_slab = nullptr;
+    while (m_state->slabs != nullptr) {
+      slab_header *slab = m_state->slabs;
+      m_state->slabs = slab->next;
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(slab);
+      const uintptr_t at = reinterpret_cast<uintptr_t>(kept);
+      if (at >= begin && at < begin + slab->bytes)
+        kept_slab = slab;
+      else
+        free_slab(alloc, slab);
+    }
+    if (kept_slab == nullptr) {
+      free_state(alloc);
+      return;
+    }
+
+    *m_state = pool_state{};
+    kept_slab->next = nullptr;
+    m_state->slabs = kept_slab;
+    if (!kept_slab->uniform)
+      return;
+    char *node = reinterpret_cast<char *>(kept_slab) + kHeaderBytes;
+    for (; node < reinterpret_cast<char *>(kept_slab) + kept_slab->bytes;
+         node += kept_slab->node_bytes)
+      if (node != kept)
+        deallocate(kept_slab->cls, node);
+  }
+
+  void swap(WTreeNodePool &other) noexcept {
+    std::swap(m_state, other.m_state);
+    m_arena.swap(other.m_arena);
+  }
+
+  const arena_type &arena() const { return m_arena; }
+
+private:
+  static constexpr size_t kHeaderBytes = round_bytes(sizeof(slab_header));
+
+  pool_state &state(Alloc &alloc) {
+    if (m_state == nullptr) {
+      state_allocator_type state_alloc(alloc);
+      m_state = state_allocator_traits::allocate(state_alloc, 1);
+      state_allocator_traits::construct(state_alloc, m_state);
+    }
+    return *m_state;
+  }
+
+  void free_state(Alloc &alloc) {
+    state_allocator_type state_alloc(alloc);
+    state_allocator_traits::destroy(state_alloc, m_state);
+    state_allocator_traits::deallocate(state_alloc, m_state, 1);
+    m_state = nullptr;
+  }
+
+  static size_t unused_bytes(const size_class &c) {
+    return reinterpret_cast<char *>(c.slab) + c.slab->bytes - c.cursor;
+  }
+
+  void add_slab(Alloc &alloc, size_class &c, size_t cls, size_t bytes) {
+    c.cursor = new_slab(alloc, kHeaderBytes + c.slab_nodes * bytes, cls, bytes,
+                        true);
+    c.slab = m_state->slabs;
+    if (2 * c.slab_nodes * bytes <= SlabBytes)
+      c.slab_nodes *= 2;
+  }
+
+  // Huge-page regions bound the slabs of a run.
+  static constexpr size_t kMaxRunSlabBytes =
+      HugePages && !Handles ? WTreeHugePageArena::kMaxBlockBytes
+                            : ~size_t(0);
+
+  // Starts a slab for the rest of the run, or as much of it as fits in a
+  // slab, with room for at least bytes. Nodes in it are of mixed classes.
+  void add_run_slab(Alloc &alloc, size_t bytes) {
+    const size_t run_bytes =
+        std::min(m_state->run_left, kMaxRunSlabBytes - kHeaderBytes);
+    const size_t slab_bytes = kHeaderBytes + std::max(bytes, run_bytes);
+    m_state->run = new_slab(alloc, slab_bytes, 0, 0, false);
+    m_state->run_end = reinterpret_cast<char *>(m_state->slabs) + slab_bytes;
+  }
+
+  // Chains a new slab of slab_bytes, and returns where its nodes start.
+  char *new_slab(Alloc &alloc, size_t slab_bytes, size_t cls, size_t bytes,
+                 bool uniform) {
+    char *raw = nullptr;
+    if constexpr (Handles)
+      raw = static_cast<char *>(m_arena.allocate(slab_bytes));
+    else if constexpr (HugePages)
+      if (slab_bytes <= WTreeHugePageArena::kMaxBlockBytes)
+        raw = static_cast<char *>(m_arena.allocate(slab_bytes));
+    const bool mapped = raw != nullptr;
+    if (!mapped)
+      raw = allocator_traits::allocate(alloc, slab_bytes);
+    m_state->slabs = new (raw)
+        slab_header{m_state->slabs, slab_bytes, static_cast<uint32_t>(cls),
+                    static_cast<uint32_t>(bytes), uniform, mapped};
+    return raw + kHeaderBytes;
+  }
+
+  void free_slab(Alloc &alloc, slab_header *slab) {
+    if constexpr (Handles) {
+      m_arena.deallocate(slab, slab->bytes);
+      return;
+    } else if constexpr (HugePages)
+      if (slab->mapped) {
+        m_arena.deallocate(slab);
+        return;
+      }
+    allocator_traits::deallocate(alloc, reinterpret_cast<char *>(slab),
+                                 slab->bytes);
+  }
+
+  pool_state *m_state = nullptr;
+  [[no_unique_address]] arena_type m_arena;
+};
+
+} // namespace WTreeLib
+#endif
@@ -0,0 +1,135 @@
+#ifndef _WTREE_PATH_STACK__H_
+#define _WTREE_PATH_STACK__H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace WTreeLib {
+
+/**
+ * Stack of the path an iterator took from the root (see
+ * WTREE_ITERATOR_PATH_DEPTH), holding its first N entries inline so that
+ * descents and iterator copies do not allocate.
+ *
+ * Deeper paths, which skewed trees (e.g. filled in key order) can have,
+ * move the stack to the heap, doubling its capacity as it grows. Copies
+ * only take the entries in use.
+ */
+template <typename T, size_t N> class WTreePathStack {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Path entries are copied as bytes.");
+  static_assert(N > 0, "The inline capacity must be positive.");
+
+public:
+  WTreePathStack() noexcept {}
+  WTreePathStack(const WTreePathStack &other) { assign(other); }
+  WTreePathStack(WTreePathStack &&other) noexcept { steal(other); }
+  ~WTreePathStack() { release(); }
+
+  WTreePathStack &operator=(const WTreePathStack &other) {
+    if (&other != this)
+      assign(other);
+    return *this;
+  }
+  WTreePathStack &operator=(WTreePathStack &&other) noexcept {
+    if (&other != this) {
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+  size_t size() const noexcept { return m_size; }
+  bool empty() const noexcept { return m_size == 0; }
+  // Whether the entries moved to the heap.
+  bool spilled() const noexcept { return m_data != m_inline; }
+
+  T &operator[](size_t i) noexcept {
+    assert(i < m_size);
+    return m_data[i];
+  }
+  const T &operator[](size_t i) const noexcept {
+    assert(i < m_size);
+    return m_data[i];
+  }
+  T &back() noexcept {
+    assert(m_size > 0);
+    return m_data[m_size - 1];
+  }
+  const T &back() const noexcept {
+    assert(m_size > 0);
+    return m_data[m_size - 1];
+  }
+
+  T *begin() noexcept { return m_data; }
+  T *end() noexcept { return m_data + m_size; }
+  const T *begin() const noexcept { return m_data; }
+  const T *end() const noexcept { return m_data + m_size; }
+
+  void push_back(T value) {
+    if (m_size == m_capacity)
+      reserve(2 * m_capacity);
+    m_data[m_size++] = value;
+  }
+  void pop_back() noexcept {
+    assert(m_size > 0);
+    --m_size;
+  }
+  void clear() noexcept { m_size = 0; }
+
+  void reserve(size_t capacity) {
+    if (capacity <= m_capacity)
+      return;
+    T *data = new T[capacity];
+    copy(data, m_data, m_size);
+    release();
+    m_data = data;
+    m_capacity = static_cast<uint32_t>(capacity);
+  }
+
+private:
+  static void copy(T *to, const T *from, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+      to[i] = from[i];
+  }
+
+  void assign(const WTreePathStack &other) {
+    m_size = 0;
+    reserve(other.m_size);
+    copy(m_data, other.m_data, other.m_size);
+    m_size = other.m_size;
+  }
+
+  // Takes the entries of other, leaving it empty.
+  void steal(WTreePathStack &other) noexcept {
+    if (other.spilled()) {
+      m_data = other.m_data;
+      m_capacity = other.m_capacity;
+      other.m_data = other.m_inline;
+      other.m_capacity = N;
+    } else {
+      m_data = m_inline;
+      m_capacity = N;
+      copy(m_data, other.m_data, other.m_size);
+    }
+    m_size = other.m_size;
+    other.m_size = 0;
+  }
+
+  void release() noexcept {
+    if (spilled())
+      delete[] m_data;
+    m_data = m_inline;
+    m_capacity = N;
+  }
+
+  T *m_data = m_inline;
+  uint32_t m_size = 0;
+  uint32_t m_capacity = N;
+  T m_inline[N];
+};
+
+} // namespace WTreeLib
+#endif
@@ -0,0 +1,123 @@
+#ifndef _WTREE_REVERSE_ITERATOR__H_
+#define _WTREE_REVERSE_ITERATOR__H_
+
+#include "iterator.hpp"
+
+#include <iterator>
+#include <utility>
+
+namespace WTreeLib {
+
+/**
+ * Reverse iterator of a WTree. Unlike std::reverse_iterator, which keeps
+ * the iterator one past the value it refers to, it keeps a WTreeIterator
+ * at that value: dereferencing reads the value in place, and stepping
+ * back decrements the iterator without copying its path.
+ *
+ * The least value of a WTree is always the first of its root (children
+ * only come after a value), so rend() is the root at index -1.
+ */
+template <typename Node, typename Reference, typename Pointer>
+class WTreeReverseIterator {
+public:
+  typedef WTreeIterator<Node, Reference, Pointer> iterator_type;
+  typedef typename iterator_type::key_type key_type;
+  typedef typename iterator_type::value_type value_type;
+  typedef typename iterator_type::difference_type difference_type;
+  typedef typename iterator_type::normal_node normal_node;
+  typedef typename iterator_type::pointer pointer;
+  typedef typename iterator_type::reference reference;
+  typedef std::bidirectional_iterator_tag iterator_category;
+
+  typedef WTreeReverseIterator<normal_node,
+                               typename iterator_type::normal_reference,
+                               typename iterator_type::normal_pointer>
+      iterator;
+  typedef WTreeReverseIterator<const Node,
+                               typename iterator_type::const_reference,
+                               typename iterator_type::const_pointer>
+      const_iterator;
+  typedef WTreeReverseIterator<Node, Reference, Pointer> self_type;
+
+  WTreeReverseIterator() = default;
+
+  // Refers to the value before x, as std::reverse_iterator(x) does, e.g.
+  // the last value below a key for x = lower_bound(key).
+  explicit WTreeReverseIterator(iterator_type x) : current(std::move(x)) {
+    step_back();
+  }
+
+  // This is the normal-to-const iterator convertion.
+  template <typename OtherNode, typename OtherRef, typename OtherPtr>
+  WTreeReverseIterator(
+      const WTreeReverseIterator<OtherNode, OtherRef, OtherPtr> &other)
+      : current(other.current) {}
+
+  // The iterator to the value after this one, as in std::reverse_iterator.
+  iterator_type base() const {
+    iterator_type x = current;
+    if (x.index < 0)
+      x.index = 0;
+    else
+      x.increment();
+    return x;
+  }
+
+  // Accessors for the key/value the iterator is pointing at.
+  const key_type &key() const { return current.key(); }
+  reference operator*() const { return *current; }
+  pointer operator->() const { return current.operator->(); }
+
+  template <typename OtherNode, typename OtherRef, typename OtherPtr>
+  bool operator==(
+      const WTreeReverseIterator<OtherNode, OtherRef, OtherPtr> &x) const {
+    return current.node == x.current.node && current.index == x.current.index;
+  }
+  template <typename OtherNode, typename OtherRef, typename OtherPtr>
+  bool operator!=(
+      const WTreeReverseIterator<OtherNode, OtherRef, OtherPtr> &x) const {
+    return !(*this == x);
+  }
+
+  self_type &operator++() {
+    step_back();
+    return *this;
+  }
+  self_type &operator--() {
+    step_forward();
+    return *this;
+  }
+  self_type operator++(int) {
+    self_type tmp = *this;
+    step_back();
+    return tmp;
+  }
+  self_type operator--(int) {
+    self_type tmp = *this;
+    step_forward();
+    return tmp;
+  }
+
+private:
+  // Past the first value, the root is left at index -1.
+  void step_back() {
+    if (current.index == 0 && !current.has_ascendant())
+      current.index = -1;
+    else
+      current.decrement();
+  }
+
+  void step_forward() {
+    if (current.index < 0)
+      current.index = 0;
+    else
+      current.increment();
+  }
+
+  iterator_type current;
+
+  template <typename, typename, typename> friend class WTreeReverseIterator;
+};
+
+} // namespace WTreeLib
+#endif
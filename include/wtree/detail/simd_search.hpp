@@ -0,0 +1,352 @@
+#ifndef _WTREE_SIMD_SEARCH__H_
+#define _WTREE_SIMD_SEARCH__H_
+
+#include "traits.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+// The instruction set is chosen at compile time from the target flags
+// (e.g. -mavx2, -mavx512f or -march=native). Without any of them the
+// kernels fall back to the scalar loop.
+#ifndef WTREE_DISABLE_SIMD_SEARCH
+#if defined(__AVX512F__)
+#define WTREE_SIMD_AVX512 1
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define WTREE_SIMD_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WTREE_SIMD_SSE2 1
+#include <emmintrin.h>
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+#endif
+#endif
+
+namespace WTreeLib {
+
+// ============================================================================
+// SIMD lanes — per instruction set load / broadcast / compare-to-mask
+// ============================================================================
+
+// Register type holding Key lanes for a vector width (in bits). Selected by
+// specialization: the vector types carry attributes that are dropped when
+// they are passed as template arguments (e.g. to std::conditional).
+template <typename Key, int Bits> struct WTreeSimdVector;
+
+#if defined(WTREE_SIMD_AVX512)
+template <typename Key> struct WTreeSimdVector<Key, 512> {
+  using type = __m512i;
+};
+template <> struct WTreeSimdVector<float, 512> {
+  using type = __m512;
+};
+template <> struct WTreeSimdVector<double, 512> {
+  using type = __m512d;
+};
+#elif defined(WTREE_SIMD_AVX2)
+template <typename Key> struct WTreeSimdVector<Key, 256> {
+  using type = __m256i;
+};
+template <> struct WTreeSimdVector<float, 256> {
+  using type = __m256;
+};
+template <> struct WTreeSimdVector<double, 256> {
+  using type = __m256d;
+};
+#elif defined(WTREE_SIMD_SSE2)
+template <typename Key> struct WTreeSimdVector<Key, 128> {
+  using type = __m128i;
+};
+template <> struct WTreeSimdVector<float, 128> {
+  using type = __m128;
+};
+template <> struct WTreeSimdVector<double, 128> {
+  using type = __m128d;
+};
+#endif
+
+/**
+ * Vector primitives for a sorted array of arithmetic keys.
+ * mask<OrEqual>(v, q) returns one bit per lane, set when v[lane] < q
+ * (or v[lane] <= q when OrEqual). On sorted keys the set bits are always
+ * a prefix, so popcount(mask) is the number of keys before the bound.
+ */
+template <typename Key> struct WTreeSimdLanes {
+  static constexpr bool kIsFloat =
+      std::is_same_v<Key, float> || std::is_same_v<Key, double>;
+  static constexpr bool kIsInteger =
+      std::is_integral_v<Key> && !std::is_same_v<Key, bool>;
+  static constexpr bool kIsSigned = std::is_signed_v<Key>;
+  static constexpr int kBytes = sizeof(Key);
+
+#if defined(WTREE_SIMD_AVX512)
+  static constexpr bool kSupported =
+      kIsFloat || (kIsInteger && (kBytes == 4 || kBytes == 8));
+  static constexpr int kWidth = 64 / kBytes;
+
+  using vector_type = typename WTreeSimdVector<Key, 512>::type;
+
+  static vector_type broadcast(Key q) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm512_set1_ps(q);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm512_set1_pd(q);
+    else if constexpr (kBytes == 4)
+      return _mm512_set1_epi32(static_cast<int32_t>(q));
+    else
+      return _mm512_set1_epi64(static_cast<int64_t>(q));
+  }
+
+  static vector_type load(const Key *p) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm512_loadu_ps(p);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm512_loadu_pd(p);
+    else
+      return _mm512_loadu_si512(static_cast<const void *>(p));
+  }
+
+  template <bool OrEqual>
+  static unsigned mask(vector_type v, vector_type q) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm512_cmp_ps_mask(v, q, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm512_cmp_pd_mask(v, q, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ);
+    else if constexpr (kBytes == 4 && kIsSigned)
+      return OrEqual ? _mm512_cmple_epi32_mask(v, q)
+                     : _mm512_cmplt_epi32_mask(v, q);
+    else if constexpr (kBytes == 4)
+      return OrEqual ? _mm512_cmple_epu32_mask(v, q)
+                     : _mm512_cmplt_epu32_mask(v, q);
+    else if constexpr (kIsSigned)
+      return OrEqual ? _mm512_cmple_epi64_mask(v, q)
+                     : _mm512_cmplt_epi64_mask(v, q);
+    else
+      return OrEqual ? _mm512_cmple_epu64_mask(v, q)
+                     : _mm512_cmplt_epu64_mask(v, q);
+  }
+
+#elif defined(WTREE_SIMD_AVX2)
+  static constexpr bool kSupported =
+      kIsFloat || (kIsInteger && (kBytes == 4 || kBytes == 8));
+  static constexpr int kWidth = 32 / kBytes;
+
+  using vector_type = typename WTreeSimdVector<Key, 256>::type;
+
+  // AVX2 only has signed integer compares: unsigned keys are biased by the
+  // sign bit so that the signed order matches the unsigned one.
+  static __m256i bias(__m256i v) {
+    if constexpr (kIsSigned)
+      return v;
+    else if constexpr (kBytes == 4)
+      return _mm256_xor_si256(v, _mm256_set1_epi32(INT32_MIN));
+    else
+      return _mm256_xor_si256(v, _mm256_set1_epi64x(INT64_MIN));
+  }
+
+  static vector_type broadcast(Key q) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm256_set1_ps(q);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm256_set1_pd(q);
+    else if constexpr (kBytes == 4)
+      return bias(_mm256_set1_epi32(static_cast<int32_t>(q)));
+    else
+      return bias(_mm256_set1_epi64x(static_cast<int64_t>(q)));
+  }
+
+  static vector_type load(const Key *p) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm256_loadu_ps(p);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm256_loadu_pd(p);
+    else
+      return bias(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)));
+  }
+
+  template <bool OrEqual>
+  static unsigned mask(vector_type v, vector_type q) {
+    constexpr unsigned kFull = (1u << kWidth) - 1;
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm256_movemask_ps(
+          _mm256_cmp_ps(v, q, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ));
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm256_movemask_pd(
+          _mm256_cmp_pd(v, q, OrEqual ? _CMP_LE_OQ : _CMP_LT_OQ));
+    else if constexpr (kBytes == 4)
+      return OrEqual ? ~_mm256_movemask_ps(
+                           _mm256_castsi256_ps(_mm256_cmpgt_epi32(v, q))) &
+                           kFull
+                     : _mm256_movemask_ps(
+                           _mm256_castsi256_ps(_mm256_cmpgt_epi32(q, v)));
+    else
+      return OrEqual ? ~_mm256_movemask_pd(
+                           _mm256_castsi256_pd(_mm256_cmpgt_epi64(v, q))) &
+                           kFull
+                     : _mm256_movemask_pd(
+                           _mm256_castsi256_pd(_mm256_cmpgt_epi64(q, v)));
+  }
+
+#elif defined(WTREE_SIMD_SSE2)
+#if defined(__SSE4_2__)
+  static constexpr bool kHasInt64Compare = true;
+#else
+  static constexpr bool kHasInt64Compare = false;
+#endif
+  static constexpr bool kSupported =
+      kIsFloat ||
+      (kIsInteger && (kBytes == 4 || (kBytes == 8 && kHasInt64Compare)));
+  static constexpr int kWidth = 16 / kBytes;
+
+  using vector_type = typename WTreeSimdVector<Key, 128>::type;
+
+  // SSE2 only has signed integer compares: unsigned keys are biased by the
+  // sign bit so that the signed order matches the unsigned one.
+  static __m128i bias(__m128i v) {
+    if constexpr (kIsSigned)
+      return v;
+    else if constexpr (kBytes == 4)
+      return _mm_xor_si128(v, _mm_set1_epi32(INT32_MIN));
+    else
+      return _mm_xor_si128(v, _mm_set1_epi64x(INT64_MIN));
+  }
+
+  static vector_type broadcast(Key q) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm_set1_ps(q);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm_set1_pd(q);
+    else if constexpr (kBytes == 4)
+      return bias(_mm_set1_epi32(static_cast<int32_t>(q)));
+    else
+      return bias(_mm_set1_epi64x(static_cast<int64_t>(q)));
+  }
+
+  static vector_type load(const Key *p) {
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm_loadu_ps(p);
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm_loadu_pd(p);
+    else
+      return bias(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+  }
+
+  template <bool OrEqual>
+  static unsigned mask(vector_type v, vector_type q) {
+    constexpr unsigned kFull = (1u << kWidth) - 1;
+    if constexpr (std::is_same_v<Key, float>)
+      return _mm_movemask_ps(OrEqual ? _mm_cmple_ps(v, q) : _mm_cmplt_ps(v, q));
+    else if constexpr (std::is_same_v<Key, double>)
+      return _mm_movemask_pd(OrEqual ? _mm_cmple_pd(v, q) : _mm_cmplt_pd(v, q));
+    else if constexpr (kBytes == 4)
+      return OrEqual ? ~_mm_movemask_ps(
+                           _mm_castsi128_ps(_mm_cmpgt_epi32(v, q))) &
+                           kFull
+                     : _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, q)));
+#if defined(__SSE4_2__)
+    else
+      return OrEqual ? ~_mm_movemask_pd(
+                           _mm_castsi128_pd(_mm_cmpgt_epi64(v, q))) &
+                           kFull
+                     : _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(q, v)));
+#else
+    else
+      return 0;
+#endif
+  }
+
+#else
+  static constexpr bool kSupported = false;
+  static constexpr int kWidth = 1;
+#endif
+};
+
+// ============================================================================
+// SIMD search — lower/upper bound over a sorted run of arithmetic keys
+// ============================================================================
+
+template <typename Key> struct WTreeSimdSearch {
+  using lanes = WTreeSimdLanes<Key>;
+  static constexpr bool kSupported = lanes::kSupported;
+
+  // Index of the first key in [s, e) for which key < q (or key <= q when
+  // OrEqual) does not hold. Keys must be sorted in ascending order.
+  template <bool OrEqual>
+  static int bound(const Key *keys, int s, int e, const Key &q) {
+    if constexpr (kSupported) {
+      constexpr int kWidth = lanes::kWidth;
+      constexpr unsigned kFull = (1u << kWidth) - 1;
+      const auto vq = lanes::broadcast(q);
+      for (; s + kWidth <= e; s += kWidth) {
+        const unsigned m =
+            lanes::template mask<OrEqual>(lanes::load(keys + s), vq);
+        if (m != kFull)
+          return s + std::popcount(m);
+      }
+    }
+    // Scalar tail (or whole range when no SIMD path exists for Key).
+    for (; s < e; ++s) {
+      if (OrEqual ? q < keys[s] : !(keys[s] < q))
+        break;
+    }
+    return s;
+  }
+
+  static int lower_bound(const Key *keys, int s, int e, const Key &q) {
+    return bound<false>(keys, s, e, q);
+  }
+
+  static int upper_bound(const Key *keys, int s, int e, const Key &q) {
+    return bound<true>(keys, s, e, q);
+  }
+};
+
+// ============================================================================
+// Comparator detection — only the natural ascending order is vectorized
+// ============================================================================
+
+enum class WTreeSimdOrder { kNone, kLess, kLessEqual };
+
+// Maps a node-search comparator onto the vector compare it is equivalent to.
+// std::less (directly or through WTreeKeyCompareToAdapter) is a lower bound;
+// the upper-bound adapter over it is a "less or equal" scan.
+template <typename Key, typename Compare>
+struct WTreeSimdCompareOrder
+    : std::integral_constant<
+          WTreeSimdOrder,
+          (std::is_same_v<Compare, std::less<Key>> ||
+           std::is_same_v<Compare, std::less<>> ||
+           std::is_same_v<Compare, WTreeKeyCompareToAdapter<std::less<Key>>> ||
+           std::is_same_v<Compare, WTreeKeyCompareToAdapter<std::less<>>> ||
+           std::is_same_v<Compare,
+                          WTreeKeyCompareToAdapter<std::compare_three_way>>)
+              ? WTreeSimdOrder::kLess
+              : WTreeSimdOrder::kNone> {};
+
+template <typename Key, typename Compare>
+struct WTreeSimdCompareOrder<Key, WTreeUpperBoundAdapter<Key, Compare>>
+    : std::integral_constant<
+          WTreeSimdOrder,
+          WTreeSimdCompareOrder<Key, Compare>::value == WTreeSimdOrder::kLess
+              ? WTreeSimdOrder::kLessEqual
+              : WTreeSimdOrder::kNone> {};
+
+// The three-way adapter orders keys like the comparator it replaces.
+template <typename Key, typename Compare>
+struct WTreeSimdCompareOrder<Key, WTreeThreeWayCompareAdapter<Key, Compare>>
+    : WTreeSimdCompareOrder<Key, WTreeKeyCompareToAdapter<Compare>> {};
+
+// The bool view of a compare-to functor (used by upper-bound searches)
+// orders keys like the functor itself.
+template <typename Key, typename Compare, bool HaveCompareTo>
+struct WTreeSimdCompareOrder<Key, WTreeKeyComparer<Key, Compare, HaveCompareTo>>
+    : WTreeSimdCompareOrder<Key, Compare> {};
+
+} // namespace WTreeLib
+#endif
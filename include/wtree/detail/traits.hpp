@@ -1,6 +1,8 @@
 #ifndef _WTREE_TRAITS__H_
 #define _WTREE_TRAITS__H_
 
+#include <array>
+#include <compare>
 #include <cstdint>
 #include <functional>
 #include <string>
@@ -15,6 +17,10 @@
 // * [FEATURE] Use this flag for additional debug-related messages.
 // DBGVERBOSE
 
+// * [FEATURE] Use this flag to keep the linear node search scalar, even
+// when the target supports SSE2/AVX2/AVX-512 (see simd_search.hpp):
+// WTREE_DISABLE_SIMD_SEARCH
+
 #ifndef WTREE_TARGET_NODE_BYTES
 #define WTREE_TARGET_NODE_BYTES 512
 #endif
@@ -47,6 +53,146 @@
 #define WTREE_BINARY_SEARCH_THRESHOLD_NUMERIC 256
 #endif
 
+// Both thresholds are defaults for WTreeSearchThreshold<Key, Compare>, which
+// can be specialized per key type (see optional/calibrate.hpp, which
+// measures the crossover and emits such specializations). When set to 1,
+// nodes instead read the threshold at runtime from
+// WTreeCalibratedThreshold<Key, Compare>, so that it can be calibrated at
+// startup with WTreeCalibration::calibrate.
+
+#ifndef WTREE_CALIBRATED_SEARCH_THRESHOLD
+#define WTREE_CALIBRATED_SEARCH_THRESHOLD 0
+#endif
+
+// Eytzinger layout: full internal nodes keep an extra copy of their keys in
+// BFS order, searched branch-free with prefetching. Intended for read-heavy
+// workloads with large nodes; costs kTargetK keys per internal node, and
+// each write to a full internal node pays for the O(k) rebuild of that
+// copy, so that searches never write to the node. Only applies to
+// trivially copyable keys.
+
+#ifndef WTREE_EYTZINGER_INTERNAL_NODES
+#define WTREE_EYTZINGER_INTERNAL_NODES 0
+#endif
+
+// Branch-free binary search: binary searches over numeric keys use
+// conditional moves plus prefetching of both candidate midpoints instead
+// of the branching loop, to avoid the mispredictions of random lookups.
+// Only nodes past the numeric binary search threshold take that path; with
+// 4 KiB and 16 KiB nodes of random 64-bit keys it measured within noise of
+// the branching loop. Set to 1 to enable.
+
+#ifndef WTREE_BRANCHLESS_BINARY_SEARCH
+#define WTREE_BRANCHLESS_BINARY_SEARCH 0
+#endif
+
+// Fence index: when set to a stride S > 0, every S-th key of a node is also
+// copied into a small array stored after its values. Searches scan those
+// fences first and then a single block of S keys, which keeps lookups in
+// large nodes (k in the thousands) down to a few cache lines. Costs about
+// 1/S extra key bytes per node. Only applies to trivially copyable keys
+// and nodes of at least 4*S keys. Suggested strides: 16 or 32.
+
+#ifndef WTREE_NODE_FENCE_STRIDE
+#define WTREE_NODE_FENCE_STRIDE 0
+#endif
+
+// Abbreviated keys: nodes with std::string keys (ordered by std::less) keep
+// the first 8 bytes of every key as an order-preserving integer, next to
+// the values. Searches run over those integers and only read the string
+// buffers of keys whose prefix ties with the searched key. Costs 8 bytes
+// per key slot, which node sizing accounts for. Set to 0 to disable.
+
+#ifndef WTREE_STRING_KEY_PREFIXES
+#define WTREE_STRING_KEY_PREFIXES 1
+#endif
+
+// Learned node model: nodes with numeric keys keep a least-squares line
+// from key to slot, plus its maximum error, and searches only look at the
+// slots within that error of the predicted one. The model is refit by the
+// write that modifies a node more than a few times since the last fit (or
+// reallocates it); until then, searches widen their window by one slot per
+// modification, or fall back to a binary search when the keys moved
+// further. Searches never write to the node. Pays off for read-mostly
+// workloads with big, densely packed nodes; costs 24 bytes per node. Set
+// to 1 to enable.
+
+#ifndef WTREE_LEARNED_NODE_MODEL
+#define WTREE_LEARNED_NODE_MODEL 0
+#endif
+
+// Key column: map nodes with trivially copyable keys also store their keys
+// in a keys-only array right after the values array, moved in step with the
+// values. Searches read that array, so the bytes they touch no longer grow
+// with the mapped type, and numeric keys get the vectorized scans of sets.
+// Pays off for large nodes (hundreds of values); in small nodes the column
+// is one more cache line per visited node, and lookups in maps of 1 KiB
+// nodes measured about 20% slower with it. Costs sizeof(Key) per slot,
+// which node sizing accounts for. Set to 1 to enable.
+
+#ifndef WTREE_MAP_KEY_COLUMN
+#define WTREE_MAP_KEY_COLUMN 0
+#endif
+
+// Out-of-line map values: maps whose pair<const Key, Data> takes at least
+// this many bytes (and whose keys are trivially copyable) store each value
+// in its own allocation, made with the tree's allocator. Node slots then
+// hold a pointer (plus the allocator, if it has state) and a key column
+// entry, so restructuring nodes never moves payloads and nodes keep a high
+// k. Costs an allocation per value and a pointer chase per dereference.
+// Specialize WTreeStoreOutOfLine to decide per value type; 0 disables.
+
+#ifndef WTREE_MAP_OUT_OF_LINE_BYTES
+#define WTREE_MAP_OUT_OF_LINE_BYTES 128
+#endif
+
+// Node slabs: each tree carves its nodes out of slabs of up to this many
+// bytes, with a free list per node size (leaf capacities follow the growth
+// sequence, and internal nodes have a single size), so that growing,
+// splitting and merging leaves recycle nodes instead of going through the
+// allocator. Erases only put nodes back on their free lists: slabs are
+// returned when the tree is cleared or destroyed, and by shrink_to_fit().
+// The pool state is allocated with the first node, so an empty tree holds
+// no memory. Set to 0 to allocate every node from the allocator.
+
+#ifndef WTREE_NODE_SLAB_BYTES
+#define WTREE_NODE_SLAB_BYTES 65536
+#endif
+
+// Huge-page node slabs: node slabs are carved out of 2 MiB regions mapped
+// from the OS, with explicit huge pages when the system reserved some and
+// transparent huge pages otherwise, so that random descents through large
+// trees (millions of nodes) miss the TLB less. Each tree maps its own
+// regions (at least 2 MiB per tree) and unmaps them as they empty; nodes
+// come from the allocator when no region can be mapped. Needs node slabs.
+// Set to 1 to enable.
+
+#ifndef WTREE_NODE_HUGE_PAGES
+#define WTREE_NODE_HUGE_PAGES 0
+#endif
+
+// Child handles: internal nodes refer to their children by 32-bit handles
+// instead of 8-byte pointers, which takes almost half the bytes off
+// internal nodes with 4-byte keys. Handles are offsets into a 64 GiB span
+// of address space reserved once per process and shared by all such trees
+// (reserved without access, only the chunks carved for nodes take memory),
+// so that nodes come from that span and never from the allocator. Needs
+// node slabs and a 64-bit address space. Set to 1 to enable.
+
+#ifndef WTREE_NODE_CHILD_HANDLES
+#define WTREE_NODE_CHILD_HANDLES 0
+#endif
+
+// Iterator paths: iterators keep the nodes they descended from on a stack
+// of this many levels held inline, so that lookups and iterator copies do
+// not allocate. Random-order trees stay well below it (a million keys take
+// under 10 levels with the default node bytes); deeper paths move the
+// stack to the heap.
+
+#ifndef WTREE_ITERATOR_PATH_DEPTH
+#define WTREE_ITERATOR_PATH_DEPTH 16
+#endif
+
 // === End of user setup ===
 // =========================
 
@@ -58,6 +204,19 @@
 #define SAFE_NEW_SIZE(current_size, limit, k)                                  \
   current_size < limit ? NEW_SIZE(current_size) : k
 
+// Hint to load the cache line holding addr ahead of a read. MSVC has no
+// __builtin_prefetch: x86 targets use the SSE intrinsic, and the hint is
+// dropped elsewhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define WTREE_PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define WTREE_PREFETCH(addr)                                                   \
+  _mm_prefetch(reinterpret_cast<const char *>(addr), _MM_HINT_T0)
+#else
+#define WTREE_PREFETCH(addr) ((void)(addr))
+#endif
+
 namespace WTreeLib {
 
 // ============================================================================
@@ -77,8 +236,11 @@ struct WTreeRulesAssumptions {
   static const bool split_to_right_first = true;
 };
 
+// ValueType is what node slots hold (the value, or a handle to it), and
+// SlotBytes the size of one slot: ValueType plus the copy of its key when
+// nodes keep a key column.
 template <typename Key, int TargetNodeBytes = WTREE_TARGET_NODE_BYTES,
-          typename ValueType = Key>
+          typename ValueType = Key, size_t SlotBytes = sizeof(ValueType)>
 struct WTreeSizeHelper {
 public:
   using key_type = Key;
@@ -86,7 +248,7 @@ public:
   using difference_type = std::ptrdiff_t;
 
   static constexpr uint kTargetBytes = TargetNodeBytes;
-  static constexpr ushort value_size = sizeof(value_type);
+  static constexpr ushort value_size = SlotBytes;
 
   // Helper to compute aligned offset for values array.
   // This accounts for padding between base_fields and values due to
@@ -160,6 +322,32 @@ public:
   }
 };
 
+// Node sizing of a params type: every byte a slot takes in the node counts
+// against the target node bytes, the entries of the per-slot arrays that
+// Params turns on included. Read from the final params type, so that params
+// deriving from WTreeCommonParams can turn those arrays on.
+template <typename Params> struct WTreeNodeSizing {
+  using key_type = typename Params::key_type;
+  using slot_type = typename Params::slot_type;
+
+  static constexpr size_t kSlotBytes =
+      sizeof(slot_type) + (Params::kUseKeyColumn ? sizeof(key_type) : 0) +
+      (Params::kUseKeyPrefixes ? sizeof(uint64_t) : 0);
+  using size_helper = WTreeSizeHelper<key_type, Params::kTargetNodeBytes,
+                                      slot_type, kSlotBytes>;
+
+  static constexpr uint kTargetK =
+      size_helper::determine_optimal_k(Params::kTargetNodeBytes);
+  static constexpr uint kLastGrowth =
+      size_helper::determine_last_growth_limit(kTargetK);
+  using field_type = std::conditional_t<(kTargetK < 255), uint8_t, uint16_t>;
+
+  // Whether binary search should be used for full internal nodes.
+  // Internal nodes are always full with kTargetK elements.
+  static constexpr bool kUseBinarySearchForInternal =
+      kTargetK >= Params::kBinarySearchThreshold;
+};
+
 // ============================================================================
 // Key Comparison Traits — tag dispatch, adapters, and comparers
 // ============================================================================
@@ -222,6 +410,46 @@ struct WTreeKeyCompareToAdapter<std::greater<std::string>>
   }
 };
 
+// std::compare_three_way over keys that keep the boolean compare (see
+// WTreeIsThreeWayCompare) is applied as the natural ascending order.
+template <>
+struct WTreeKeyCompareToAdapter<std::compare_three_way> : public std::less<> {
+  WTreeKeyCompareToAdapter() {}
+  WTreeKeyCompareToAdapter(const std::compare_three_way &c) {}
+  WTreeKeyCompareToAdapter(
+      const WTreeKeyCompareToAdapter<std::compare_three_way> &c) {}
+};
+
+// A helper class that indicates if keys of type Key ordered by Compare are
+// compared through their operator<=>: one call then tells less, equal and
+// greater apart. This holds for class keys (std::string_view, composite
+// keys) under the transparent std::less<> or std::compare_three_way.
+// Arithmetic and pointer keys keep the boolean compare, which is cheap and
+// the one the vectorized searches are built on. So do keys whose operator<=>
+// is only a partial order (e.g. over floating point members): an unordered
+// result has no place in a compare-to int, while operator< just says false.
+template <typename Key, typename Compare>
+struct WTreeIsThreeWayCompare
+    : std::integral_constant<
+          bool, (std::is_same_v<Compare, std::less<>> ||
+                 std::is_same_v<Compare, std::compare_three_way>) &&
+                    std::is_class_v<Key> &&
+                    std::three_way_comparable<Key, std::weak_ordering>> {};
+
+// The compare-to functor used when WTreeIsThreeWayCompare holds: maps the
+// ordering returned by operator<=> onto a negative, zero or positive int.
+template <typename Key, typename Compare>
+struct WTreeThreeWayCompareAdapter : public WTreeKeyCompareToTag {
+  static_assert(std::three_way_comparable<Key, std::weak_ordering>,
+                "Partially ordered keys would map unordered to equal.");
+  WTreeThreeWayCompareAdapter() {}
+  WTreeThreeWayCompareAdapter(const Compare &) {}
+  int operator()(const Key &a, const Key &b) const {
+    const auto c = a <=> b;
+    return (c > 0) - (c < 0);
+  }
+};
+
 // A helper class that allows a compare-to functor to behave like a plain
 // compare functor. This specialization is used when we do not have a
 // compare-to functor.
@@ -266,6 +494,52 @@ static bool wtree_compare_keys(const Compare &comp, const Key &x,
   return key_comparer::bool_compare(comp, x, y);
 }
 
+// Minimum number of keys from which a node is searched with binary rather
+// than linear search, for keys of type Key ordered by Compare.
+template <typename Key, typename Compare> struct WTreeSearchThreshold {
+  static constexpr uint value = std::is_integral_v<Key> ||
+                                        std::is_floating_point_v<Key>
+                                    ? WTREE_BINARY_SEARCH_THRESHOLD_NUMERIC
+                                    : WTREE_BINARY_SEARCH_THRESHOLD_COMPLEX;
+};
+
+// Runtime copy of WTreeSearchThreshold, used by the nodes when
+// WTREE_CALIBRATED_SEARCH_THRESHOLD is set.
+template <typename Key, typename Compare> struct WTreeCalibratedThreshold {
+  static inline uint value = WTreeSearchThreshold<Key, Compare>::value;
+};
+
+// Whether maps with values of type Value (pair<const Key, Data>) store them
+// out of line, see WTREE_MAP_OUT_OF_LINE_BYTES. Specialize it to force
+// either layout for a value type.
+template <typename Value>
+struct WTreeStoreOutOfLine
+    : std::integral_constant<bool, WTREE_MAP_OUT_OF_LINE_BYTES != 0 &&
+                                       sizeof(Value) >=
+                                           WTREE_MAP_OUT_OF_LINE_BYTES> {};
+
+// Order-preserving integer prefix of a key: a < b implies
+// get(a) <= get(b). Keys with different prefixes compare like them.
+template <typename Key> struct WTreeKeyPrefix {
+  static constexpr bool kSupported = false;
+};
+
+template <> struct WTreeKeyPrefix<std::string> {
+  static constexpr bool kSupported = true;
+  // First 8 bytes, big-endian and zero padded, so that unsigned integer
+  // order matches the byte-wise order of std::string::compare.
+  static uint64_t get(const std::string &s) {
+    unsigned char bytes[8] = {};
+    const size_t n = s.size() < 8 ? s.size() : 8;
+    for (size_t i = 0; i < n; ++i)
+      bytes[i] = static_cast<unsigned char>(s[i]);
+    uint64_t prefix = 0;
+    for (int i = 0; i < 8; ++i)
+      prefix = (prefix << 8) | bytes[i];
+    return prefix;
+  }
+};
+
 // ============================================================================
 // Key Extraction Traits — tag dispatch for set vs map value extraction
 // ============================================================================
@@ -316,6 +590,64 @@ struct WTreeUpperBoundAdapter : public Compare {
   }
 };
 
+// Node search algorithms, selectable through the node search API or per
+// container (see WTreeSearchPolicy). kAuto picks per node kind from the
+// container params. kLinear scans key by key, while kSimd scans with the
+// vector kernels of simd_search.hpp (numeric set keys in their natural
+// order, kLinear otherwise). kInterpolation guesses the slot of the key
+// between key(0) and key(size-1), for near-uniform arithmetic keys in their
+// natural order; other keys or comparators fall back to binary search.
+// kCustom calls the lower_bound of the container's search policy.
+enum class WTreeSearchMethod {
+  kAuto,
+  kLinear,
+  kBinary,
+  kBranchless,
+  kInterpolation,
+  kSimd,
+  kCustom
+};
+
+// Search policy of a container: the methods used for internal nodes and for
+// leaves. A policy that uses kCustom must also provide
+//
+//   template <typename Node, typename Compare>
+//   static int lower_bound(const Node &node, const typename Node::key_type &k,
+//                          int s, int e, const Compare &comp);
+//
+// returning the first slot i in [s, e] whose node.key(i) is not left of k:
+// comp(node.key(i), k) is false, or >= 0 for comparators returning int.
+template <WTreeSearchMethod Internal = WTreeSearchMethod::kAuto,
+          WTreeSearchMethod Leaf = Internal>
+struct WTreeSearchPolicy {
+  static constexpr WTreeSearchMethod kInternalMethod = Internal;
+  static constexpr WTreeSearchMethod kLeafMethod = Leaf;
+};
+
+// Fills order[slot] (1-based BFS slot of an Eytzinger array of N keys) with
+// its in-order rank, so a search result can be mapped back to the position of
+// the key in the sorted array.
+template <typename Index, size_t N>
+constexpr size_t wtree_eytzinger_fill(std::array<Index, N + 1> &order,
+                                      size_t slot, size_t rank) {
+  if (slot > N)
+    return rank;
+  rank = wtree_eytzinger_fill<Index, N>(order, 2 * slot, rank);
+  order[slot] = static_cast<Index>(rank++);
+  return wtree_eytzinger_fill<Index, N>(order, 2 * slot + 1, rank);
+}
+
+template <typename Index, size_t N>
+constexpr std::array<Index, N + 1> wtree_eytzinger_order() {
+  std::array<Index, N + 1> order{};
+  wtree_eytzinger_fill<Index, N>(order, 1, 0);
+  return order;
+}
+
+template <typename Index, size_t N>
+inline constexpr std::array<Index, N + 1> kWTreeEytzingerOrder =
+    wtree_eytzinger_order<Index, N>();
+
 // ============================================================================
 // Utilities
 // ============================================================================
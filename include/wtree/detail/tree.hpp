@@ -14,6 +14,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <span>
 #include <sys/types.h>
 #include <type_traits>
 #include <utility>
@@ -43,6 +44,7 @@ public:
   using typename Aliases::mapped_type;
   using typename Aliases::size_type;
   using typename Aliases::value_type;
+  using typename Aliases::slot_type;
 
   using typename Aliases::is_key_compare_to;
   using typename Aliases::key_compare;
@@ -96,13 +98,14 @@ public:
   WTree(self_type &&other) noexcept
       : key_compare(std::move(other.key_comp())),
         m_manager(std::move(other.m_manager)), m_locator(key_comp()) {
-    other.m_manager.set_root(nullptr);
+    other.m_manager.set_root(manager_type::empty_root());
     other.m_manager.set_size(0);
   }
 
-  // Destructor.
+  // Destructor. The manager frees whatever its slabs still hold.
   ~WTree() {
-    m_manager.internal_recursive_delete(root());
+    if constexpr (!manager_type::kDeleteInBulk)
+      m_manager.delete_tree(root());
     mutable_root() = nullptr;
   }
 
@@ -172,7 +175,8 @@ public:
     using std::swap;
     swap(static_cast<key_compare &>(*this), static_cast<key_compare &>(other));
     swap(m_manager.m_size, other.m_manager.m_size);
-    swap(m_manager.m_root, other.m_manager.m_root);
+    swap(m_manager.m_root.data, other.m_manager.m_root.data);
+    m_manager.m_pool.swap(other.m_manager.m_pool);
     if constexpr (internal_allocator_traits::propagate_on_container_swap::
                       value) {
       swap(mutable_allocator(), other.mutable_allocator());
@@ -185,7 +189,7 @@ public:
   // Does not invalidate the source tree.
   void assign(const self_type &other) {
     // Clean up existing tree
-    m_manager.internal_recursive_delete(root());
+    m_manager.delete_tree(root());
 
     // Copy comparator and allocator
     mutable_key_comp() = other.key_comp();
@@ -198,11 +202,11 @@ public:
     }
 
     // Deep clone the tree structure
-    if (other.croot()) {
+    if (!manager_type::is_empty_root(other.croot())) {
       mutable_root() = clone_subtree(other.croot());
       m_manager.set_size(other.size());
     } else {
-      mutable_root() = m_manager.new_internal_node();
+      mutable_root() = manager_type::empty_root();
       m_manager.set_size(0);
     }
   }
@@ -220,13 +224,14 @@ private:
   // Uses optimal method based on type traits.
   static void copy_construct_values(node_type *dest, const node_type *src,
                                     size_t count) {
-    if constexpr (std::is_trivially_copyable_v<value_type>) {
+    if constexpr (std::is_trivially_copyable_v<slot_type>) {
       std::memcpy(static_cast<void *>(dest->fields.values),
                   static_cast<const void *>(src->fields.values),
-                  count * sizeof(value_type));
+                  count * sizeof(slot_type));
     } else {
       std::uninitialized_copy_n(src->fields.values, count, dest->fields.values);
     }
+    node_type::copy_search_keys(src, 0, count, dest, 0);
   }
 
   /**
@@ -246,7 +251,7 @@ private:
       // Recursively clone children
       for (field_type i = 0; i < kTargetK - 1; ++i) {
         if (src->child(i)) {
-          dest->fields.pointers[i] = clone_subtree(src->child(i));
+          dest->set_child(i, clone_subtree(src->child(i)));
         }
       }
     } else {
@@ -257,6 +262,7 @@ private:
     // Copy values
     copy_construct_values(dest, src, src->size());
     dest->fields.size = src->size();
+    dest->refresh_search_layout();
 
     return dest;
   }
@@ -275,24 +281,21 @@ public:
   }
 
   /**
-   * @brief Leaves the tree in a valid empty state
-   * (with an existing root internal node).
+   * @brief Reallocates every node, leaves to the least capacity holding
+   * their values, laid out depth-first (in slabs of their own with node
+   * slabs), so that the memory left by erases is recovered and descents
+   * and scans read mostly consecutive memory. An empty tree gives its root
+   * back. Invalidates iterators.
+   */
+  void shrink_to_fit() { mutable_root() = m_manager.compact_tree(root()); }
+
+  /**
+   * @brief Leaves the tree in a valid empty state, holding no node (its
+   * root is the shared empty root).
    */
   void clear() {
-    assert(root()->is_internal());
-    node_type *node = root();
-    for (field_type i = 0; i < kTargetK - 1; ++i) {
-      if (node->child(i) != nullptr) {
-        m_manager.internal_recursive_delete(node->child(i));
-        node->set_child(i, nullptr);
-      }
-    }
-    // Lazy remove.
-    node->fields.size = 0;
-#ifndef NDEBUG
-    memset(static_cast<void *>(node->fields.values), 0,
-           sizeof(node->fields.values));
-#endif
+    m_manager.delete_tree(root());
+    mutable_root() = manager_type::empty_root();
     m_manager.set_size(0);
   }
 
@@ -306,17 +309,17 @@ public:
   }
   reverse_iterator rbegin() { return reverse_iterator(end()); }
   const_reverse_iterator rbegin() const {
-    return const_reverse_iterator(end());
+    return const_reverse_iterator(cend());
   }
   const_reverse_iterator crbegin() const {
-    return const_reverse_iterator(end());
+    return const_reverse_iterator(cend());
   }
   reverse_iterator rend() { return reverse_iterator(begin()); }
   const_reverse_iterator rend() const {
-    return const_reverse_iterator(begin());
+    return const_reverse_iterator(cbegin());
   }
   const_reverse_iterator crend() const {
-    return const_reverse_iterator(begin());
+    return const_reverse_iterator(cbegin());
   }
 
   bool is_empty() const { return size() == 0; }
@@ -326,6 +329,54 @@ public:
     return node->bounds_key(key, key_comp());
   }
 
+  // #region WTREE_BLOCK_ROUTINES
+
+  // Values stored next to each other in a node, handed to block callbacks.
+  using block_type = std::span<const value_type>;
+
+  /**
+   * @brief Calls fn with every value in order, in blocks: the runs of
+   * values a node holds between two of its children, read in place from
+   * the node. fn takes a block_type, and may return false to stop the scan.
+   * Out-of-line map values are not stored next to each other, and come one
+   * per block. The tree must not change during the scan.
+   */
+  template <typename Fn> void for_each_block(Fn &&fn) const {
+    internal_for_each_block<false, false>(croot(), nullptr, nullptr, fn);
+  }
+
+  // The same for the values with keys in [lo, hi).
+  template <typename Fn>
+  void for_each_block(const key_type &lo, const key_type &hi, Fn &&fn) const {
+    internal_for_each_block<true, true>(croot(), &lo, &hi, fn);
+  }
+
+  /**
+   * @brief Calls fn with every value in reverse order, in the blocks of
+   * for_each_block() from the last one to the first. Values in a block
+   * still come in ascending order, to be read backwards by fn.
+   */
+  template <typename Fn> void for_each_block_reverse(Fn &&fn) const {
+    internal_for_each_block_reverse<false, false>(croot(), nullptr, nullptr,
+                                                  fn);
+  }
+
+  // The same for the values with keys below hi, e.g. to take the latest
+  // ones before hi.
+  template <typename Fn>
+  void for_each_block_reverse(const key_type &hi, Fn &&fn) const {
+    internal_for_each_block_reverse<false, true>(croot(), nullptr, &hi, fn);
+  }
+
+  // The same for the values with keys in [lo, hi).
+  template <typename Fn>
+  void for_each_block_reverse(const key_type &lo, const key_type &hi,
+                              Fn &&fn) const {
+    internal_for_each_block_reverse<true, true>(croot(), &lo, &hi, fn);
+  }
+
+  // #endregion
+
   // #region WTREE_INSERT_AND_EMPLACE_ROUTINES
 
   // -- Unique container operations --
@@ -560,6 +611,12 @@ public:
     return std::make_pair(iter, result);
   }
 
+  // Whether a value with key is in the tree, with the same descent as
+  // locate() but no iterator.
+  bool contains(const key_type &key) const {
+    return m_locator.internal_contains(key, croot());
+  }
+
   template <typename IterType>
   std::pair<IterType, int> locate_hint(const key_type &key,
                                        IterType &iter) const {
@@ -580,6 +637,7 @@ public:
   // Erases range. Returns the number of keys erased.
   template <typename Iterator> int erase(Iterator begin, Iterator end);
 
+public:
   // #endregion
 
 private:
@@ -628,6 +686,60 @@ private:
   template <typename IterType, typename... Args>
   IterType internal_emplace_at(IterType &hint, Args &&...args);
 
+  // Inserts a slot built from args at it, the position located for its key
+  // by emplace_unique_key_args.
+  template <typename... Args>
+  iterator internal_emplace_located(iterator &it, Args &&...args) noexcept;
+
+  // Index of the first value of u not below key.
+  int internal_node_lower_bound(const node_type *u, const key_type &key) const {
+    const int res = u->is_internal() ? u->lower_bound_internal(key, key_comp())
+                                     : u->lower_bound_leaf(key, key_comp());
+    return res & kMatchMask;
+  }
+
+  // Scans the subtree of u, from *lo when kLower and up to *hi when kUpper.
+  // Returns false when fn stopped the scan.
+  template <bool kLower, bool kUpper, typename Fn>
+  bool internal_for_each_block(const node_type *u, const key_type *lo,
+                               const key_type *hi, Fn &fn) const;
+
+  // The same as internal_for_each_block, from the last value to the first.
+  template <bool kLower, bool kUpper, typename Fn>
+  bool internal_for_each_block_reverse(const node_type *u, const key_type *lo,
+                                       const key_type *hi, Fn &fn) const;
+
+  // Hands values [first, last) of u to fn, the last one first when
+  // kReverse and they are handed one by one.
+  template <bool kReverse = false, typename Fn>
+  static bool internal_emit_block(const node_type *u, int first, int last,
+                                  Fn &fn) {
+    if constexpr (std::is_same_v<slot_type, value_type>) {
+      return internal_call_block(
+          fn, block_type(u->fields.values + first, last - first));
+    } else if constexpr (kReverse) {
+      for (int i = last - 1; i >= first; --i)
+        if (!internal_call_block(fn, block_type(&u->value(i), 1)))
+          return false;
+      return true;
+    } else {
+      for (int i = first; i < last; ++i)
+        if (!internal_call_block(fn, block_type(&u->value(i), 1)))
+          return false;
+      return true;
+    }
+  }
+
+  template <typename Fn>
+  static bool internal_call_block(Fn &fn, block_type block) {
+    if constexpr (std::is_void_v<std::invoke_result_t<Fn &, block_type>>) {
+      fn(block);
+      return true;
+    } else {
+      return static_cast<bool>(fn(block));
+    }
+  }
+
   // =====================================================================
   // Find — lower_bound + equality check. Shared logic, works for both
   // unique and multi (lower_bound always finds the first occurrence).
@@ -19,7 +19,7 @@ template <typename Params>
 WTree<Params>::WTree(const key_compare &comp, const allocator_type &alloc)
     : key_compare(comp), m_manager(internal_allocator_type(alloc)),
       m_locator(key_comp()) {
-  m_manager.set_root(m_manager.new_internal_node());
+  m_manager.set_root(manager_type::empty_root());
 
 #ifdef DBGVERBOSE
   std::printf("Creating node<value=%lu> of %lu bytes: "
@@ -65,7 +65,11 @@ WTree<Params>::WTree(const key_compare &comp, const allocator_type &alloc)
  * 2. If the node is full and internal, displace the boundary key into a
  *    descendant via edge swap, or create a new child for mid-range.
  * 3. If the node is full and a leaf, try balanced slide (R3). On failure,
- *    convert to internal and apply rule 2.
+ *    convert to internal and apply rule 2. A full root leaf has no
+ *    siblings, and is converted right away.
+ *
+ * The empty root is first replaced by a leaf of kInitialCapacity, which
+ * grows like any leaf until it fills up.
  *
  * @return {iterator, true} on insertion, {iterator, false} if key exists.
  */
@@ -75,28 +79,52 @@ std::pair<typename WTree<Params>::iterator, bool>
 WTree<Params>::emplace_unique_key_args(const key_type &key,
                                        Args &&...args) noexcept {
   assert(root() != nullptr);
+  if (manager_type::is_empty_root(root()))
+    mutable_root() = m_manager.new_leaf_node(kInitialCapacity);
 
   iterator it(root(), 0);
 
-  if (m_locator.internal_locate_any(key, it) & kExactMatch)
+  if (m_locator.internal_locate_any(key, it) == kExactMatch)
     return std::make_pair(it, false);
 
+  // Out-of-line values are boxed here, with this tree's allocator; the
+  // insert rules only move the box.
+  if constexpr (node_type::kUseOutOfLineValues)
+    return std::make_pair(
+        internal_emplace_located(it, slot_type(std::allocator_arg, allocator(),
+                                               std::forward<Args>(args)...)),
+        true);
+  else
+    return std::make_pair(
+        internal_emplace_located(it, std::forward<Args>(args)...), true);
+}
+
+/**
+ * @details Applies the insertion rules at the position found by
+ * emplace_unique_key_args.
+ */
+template <typename Params>
+template <typename... Args>
+typename WTree<Params>::iterator
+WTree<Params>::internal_emplace_located(iterator &it, Args &&...args) noexcept {
   // R2: Node not full — emplace directly.
   if (it.node->size() < kTargetK)
-    return std::make_pair(m_manager.internal_emplace_at_with_growht(
-                              it, std::forward<Args>(args)...),
-                          true);
+    return m_manager.internal_emplace_at_with_growht(
+        it, std::forward<Args>(args)...);
+
+  // Full leaf root — becomes the internal root.
+  if (it.node->is_leaf() && !it.has_ascendant())
+    it.node = mutable_root() = m_manager.make_internal(it.node);
 
   // Full leaf — try balanced slide (R3), then convert to internal.
   if (it.node->is_leaf()) {
-    assert(it.has_ascendant());
     assert(WTreeRulesAssumptions::use_slide);
     assert(!WTreeRulesAssumptions::use_split);
 
     if (m_manager.attempt_emplace_with_balanced_slide(
             it, std::forward<Args>(args)...)) {
       m_manager.increment_size();
-      return std::make_pair(it, true);
+      return it;
     }
     m_manager.make_child_internal_unchecked(it.ascendant(), it.position());
     it.internal_update_position();
@@ -108,12 +136,10 @@ WTree<Params>::emplace_unique_key_args(const key_type &key,
 
   // Edge cases. Displace boundary key via descendant chain.
   if (it.index == 0)
-    return std::make_pair(
-        m_manager.emplace_edge_swap(it, std::forward<Args>(args)...), true);
+    return m_manager.emplace_edge_swap(it, std::forward<Args>(args)...);
 
   if (it.index == kTargetK)
-    return std::make_pair(
-        m_manager.emplace_edge_swap(it, std::forward<Args>(args)...), true);
+    return m_manager.emplace_edge_swap(it, std::forward<Args>(args)...);
 
   // Mid-range: child(index-1) must be null (lower_bound would have
   // descended).
@@ -122,9 +148,10 @@ WTree<Params>::emplace_unique_key_args(const key_type &key,
   it.descend(it.index - 1);
   it.node->construct_value(0, std::forward<Args>(args)...);
   ++it.node->fields.size;
+  it.node->refresh_search_layout();
   m_manager.increment_size();
-  return std::make_pair(it, true);
-};
+  return it;
+}
 
 template <typename Params>
 template <typename... Args>
@@ -147,6 +174,114 @@ typename WTree<Params>::iterator WTree<Params>::emplace_hint_multi_key_args(
 
 // #endregion
 
+// #region WTREE_BLOCK_ROUTINES
+
+/**
+ * @details Values of a node come in order, and its child i holds the keys
+ * between values i and i+1: a node is scanned as runs of values, each
+ * ending at a value with a child, which is scanned right after the run.
+ * Only the children at the ends of the range [first, last) of the node
+ * can hold keys out of [lo, hi), and keep checking the bounds.
+ */
+template <typename Params>
+template <bool kLower, bool kUpper, typename Fn>
+bool WTree<Params>::internal_for_each_block(const node_type *u,
+                                            const key_type *lo,
+                                            const key_type *hi,
+                                            Fn &fn) const {
+  const int first = kLower ? internal_node_lower_bound(u, *lo) : 0;
+  const int last = kUpper ? internal_node_lower_bound(u, *hi) : u->size();
+
+  // The child left of first holds keys below key(first) that may reach lo.
+  if (kLower && first > 0 && first < u->size() && u->is_internal() &&
+      u->child(first - 1) != nullptr) {
+    const bool go =
+        first < last
+            ? internal_for_each_block<kLower, false>(u->child(first - 1), lo,
+                                                     hi, fn)
+            : internal_for_each_block<kLower, kUpper>(u->child(first - 1), lo,
+                                                      hi, fn);
+    if (!go)
+      return false;
+  }
+
+  for (int i = first; i < last;) {
+    int end = last;
+    const node_type *child = nullptr;
+    if (u->is_internal()) {
+      const int j = u->first_right_descendant(static_cast<field_type>(i));
+      if (j < last && j < u->size() - 1) {
+        end = j + 1;
+        child = u->child(j);
+      }
+    }
+    if (!internal_emit_block(u, i, end, fn))
+      return false;
+    if (child != nullptr) {
+      const bool go =
+          end < last
+              ? internal_for_each_block<false, false>(child, lo, hi, fn)
+              : internal_for_each_block<false, kUpper>(child, lo, hi, fn);
+      if (!go)
+        return false;
+    }
+    i = end;
+  }
+  return true;
+}
+
+/**
+ * @details Mirrors internal_for_each_block: runs of values are found from
+ * last down to first, each starting right after a child, which is scanned
+ * right before the run (children only come before the last value).
+ */
+template <typename Params>
+template <bool kLower, bool kUpper, typename Fn>
+bool WTree<Params>::internal_for_each_block_reverse(const node_type *u,
+                                                    const key_type *lo,
+                                                    const key_type *hi,
+                                                    Fn &fn) const {
+  const int first = kLower ? internal_node_lower_bound(u, *lo) : 0;
+  const int last = kUpper ? internal_node_lower_bound(u, *hi) : u->size();
+
+  int end = last;
+  if (u->is_internal()) {
+    int limit = std::min<int>(last, u->size() - 1);
+    while (limit > first) {
+      // One past the child closest to the left of limit, if any.
+      const int j = u->first_left_descendant(static_cast<field_type>(limit));
+      if (j <= first)
+        break;
+      if (j < end && !internal_emit_block<true>(u, j, end, fn))
+        return false;
+      const bool go =
+          j < last
+              ? internal_for_each_block_reverse<false, false>(u->child(j - 1),
+                                                              lo, hi, fn)
+              : internal_for_each_block_reverse<false, kUpper>(
+                    u->child(j - 1), lo, hi, fn);
+      if (!go)
+        return false;
+      end = j;
+      limit = j - 1;
+    }
+  }
+  if (first < end && !internal_emit_block<true>(u, first, end, fn))
+    return false;
+
+  // The child left of first holds keys below key(first) that may reach lo.
+  if (kLower && first > 0 && first < u->size() && u->is_internal() &&
+      u->child(first - 1) != nullptr) {
+    return first < last ? internal_for_each_block_reverse<kLower, false>(
+                              u->child(first - 1), lo, hi, fn)
+                        : internal_for_each_block_reverse<kLower, kUpper>(
+                              u->child(first - 1), lo, hi, fn);
+  }
+  return true;
+}
+
+// #endregion
+
 // #region WTREE_ERASE_ROUTINES
 
 template <typename P>
@@ -162,10 +297,10 @@ Iterator WTree<P>::erase(Iterator &iter) {
       ++iter;
     } else {
       assert(iter.node == root());
-      if constexpr (!std::is_move_assignable_v<value_type>) {
-        iter.node->destroy_value(0);
-      }
+      iter.node->destroy_value(0);
       --iter.node->fields.size;
+      iter.node->invalidate_search_layout();
+      iter.node->refresh_search_layout();
     }
     m_manager.decrement_size();
     return iter;
@@ -176,18 +311,16 @@ Iterator WTree<P>::erase(Iterator &iter) {
     // A zero value means that there was no child because [iter.index]=0 has
     // no left child.
     if (child_lower_bound > 0) {
-      node_type::safe_move_backward_range(
-          iter.node->fields.values + child_lower_bound,
-          iter.node->fields.values + iter.index,
-          iter.node->fields.values + iter.index + 1);
+      iter.node->destroy_value(iter.index);
+      node_type::move_values_backward(iter.node, child_lower_bound, iter.index,
+                                      iter.node, iter.index + 1);
 
       // Cheap copy to use for descending.
       iterator child_node(iter.node->child(child_lower_bound - 1),
                           child_lower_bound - 1);
 
-      child_node.node->move_value(child_node.node->size() - 1, iter.node,
-                                  child_lower_bound);
-
+      // Reshape the path before the value leaves the child, so a node
+      // rebuilt as a leaf never copies a moved-out slot.
       m_locator.visit_path_to_greatest_leaf_value(child_node);
       if (child_node.node->is_internal()) {
         // Node should be transform to a leaf.
@@ -200,6 +333,10 @@ Iterator WTree<P>::erase(Iterator &iter) {
         child_node.node = ancestor->child(pos);
       }
 
+      node_type *child = iter.node->child(child_lower_bound - 1);
+      child->move_value(child->size() - 1, iter.node, child_lower_bound);
+      iter.node->refresh_search_layout();
+
       m_manager.internal_move_greatest_upward(child_node);
       if (child_node.node->size() == 0) {
         m_manager.internal_destroy_child_unchecked(iter.node,
@@ -214,15 +351,13 @@ Iterator WTree<P>::erase(Iterator &iter) {
     // [iter.index] == kTarget-1 means no child was found, because
     // value at indes kTarget-1 has no right descendant.
     if (child_lower_bound < kTargetK - 1) {
-      node_type::safe_move_range(iter.node->fields.values + iter.index + 1,
-                                 iter.node->fields.values + child_lower_bound +
-                                     1,
-                                 iter.node->fields.values + iter.index);
+      iter.node->destroy_value(iter.index);
+      node_type::move_values(iter.node, iter.index + 1, child_lower_bound + 1,
+                             iter.node, iter.index);
 
       // Cheap copy to use for descending.
       iterator child_iter(iter.node->child(child_lower_bound),
                           child_lower_bound);
-      child_iter.node->move_value(0, iter.node, child_lower_bound);
 
       m_locator.visit_path_to_smallest_leaf_value(child_iter);
       if (child_iter.node->is_internal()) {
@@ -236,6 +371,10 @@ Iterator WTree<P>::erase(Iterator &iter) {
         child_iter.node = ancestor->child(pos);
       }
 
+      iter.node->child(child_lower_bound)
+          ->move_value(0, iter.node, child_lower_bound);
+      iter.node->refresh_search_layout();
+
       m_manager.internal_move_smallest_upward(child_iter);
       if (child_iter.node->size() == 0) {
         m_manager.internal_destroy_child_unchecked(iter.node,
@@ -253,10 +392,12 @@ Iterator WTree<P>::erase(Iterator &iter) {
     }
   }
 
-  node_type::safe_move_range(iter.node->fields.values + iter.index + 1,
-                             iter.node->fields.values + iter.node->size(),
-                             iter.node->fields.values + iter.index);
+  iter.node->destroy_value(iter.index);
+  node_type::move_values(iter.node, iter.index + 1, iter.node->size(),
+                         iter.node, iter.index);
   --iter.node->fields.size;
+  iter.node->invalidate_search_layout();
+  iter.node->refresh_search_layout();
   m_manager.decrement_size();
   return iter;
 }
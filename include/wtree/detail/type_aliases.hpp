@@ -3,8 +3,7 @@
 
 #include "iterator.hpp"
 #include "node.hpp"
-
-#include <iterator>
+#include "reverse_iterator.hpp"
 
 namespace WTreeLib {
 
@@ -20,11 +19,12 @@ template <typename Params> struct WTreeTypeAliases {
   using internal_fields_type = typename node_type::internal_fields;
 
   // --- Key / value types ---
-  using field_type = typename params_type::field_type;
+  using field_type = typename node_type::field_type;
   using key_type = typename Params::key_type;
   using data_type = typename Params::data_type;
   using mapped_type = typename Params::mapped_type;
   using value_type = typename Params::value_type;
+  using slot_type = typename Params::slot_type;
   using size_type = typename Params::size_type;
   using difference_type = typename Params::difference_type;
 
@@ -41,8 +41,8 @@ template <typename Params> struct WTreeTypeAliases {
   // --- Iterators ---
   using iterator = WTreeIterator<node_type, reference, pointer>;
   using const_iterator = typename iterator::const_iterator;
-  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
-  using reverse_iterator = std::reverse_iterator<iterator>;
+  using reverse_iterator = WTreeReverseIterator<node_type, reference, pointer>;
+  using const_reverse_iterator = typename reverse_iterator::const_iterator;
 
   // --- Allocator ---
   using allocator_type = typename Params::allocator_type;
@@ -53,8 +53,8 @@ template <typename Params> struct WTreeTypeAliases {
   // --- Static constants ---
   static constexpr bool kUnique = params_type::kUnique;
   static constexpr uint kTargetNodeBytes = params_type::kTargetNodeBytes;
-  static constexpr field_type kTargetK = Params::kTargetK;
-  static constexpr field_type kLastGrowth = Params::kLastGrowth;
+  static constexpr field_type kTargetK = node_type::kTargetK;
+  static constexpr field_type kLastGrowth = node_type::kLastGrowth;
   static constexpr uint kBasefieldsBytes = node_type::kBasefieldsBytes;
   static constexpr field_type kInitialCapacity = node_type::kInitialCapacity;
 
@@ -56,10 +56,11 @@ public:
     return this->end();
   }
   const_iterator find(const key_type &key) const {
-    const_iterator iter(this->m_tree.root(), 0);
+    const_iterator iter(this->m_tree.croot(), 0);
     auto [it, _] = this->m_tree.lower_bound(key, iter);
     if (it != this->cend()) {
-      if (!this->m_tree.locator()->compare_keys(key, params_type::get_key(*it)))
+      if (!this->m_tree.clocator()->compare_keys(key,
+                                                 params_type::get_key(*it)))
         return it;
     }
     return this->cend();
@@ -76,10 +77,8 @@ public:
   }
 
   size_type count(const key_type &key) const {
-    // Early-stop locate is more efficient than full descent for unique.
-    const_iterator iter(this->m_tree.croot(), 0);
-    auto res = this->m_tree.locate(key, iter);
-    return (res.second == Tree::kExactMatch) ? 1 : 0;
+    // Early-stop descent, without an iterator, is enough for unique keys.
+    return this->m_tree.contains(key) ? 1 : 0;
   }
 
   // === Insertion routines ===
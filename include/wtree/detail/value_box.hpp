@@ -0,0 +1,75 @@
+#ifndef _WTREE_VALUE_BOX__H_
+#define _WTREE_VALUE_BOX__H_
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace WTreeLib {
+
+/**
+ * Owning handle to a value allocated out of line, stored by nodes in place
+ * of the value itself (see WTREE_MAP_OUT_OF_LINE_BYTES), so that slides,
+ * growth and edge swaps only move pointers.
+ *
+ * Values are allocated with the tree's allocator, rebound to Value, which
+ * the box keeps to free them (stateless allocators take no space). Moves
+ * transfer the value and the allocator and leave the source empty; copies
+ * clone the value with the same allocator, as tree copies do with nodes.
+ */
+template <typename Value, typename Alloc> class WTreeValueBox {
+  using allocator_type =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Value>;
+  using allocator_traits = std::allocator_traits<allocator_type>;
+
+public:
+  template <typename... Args>
+  WTreeValueBox(std::allocator_arg_t, const Alloc &alloc, Args &&...args)
+      : m_alloc(alloc), m_value(create(std::forward<Args>(args)...)) {}
+
+  WTreeValueBox(WTreeValueBox &&other) noexcept
+      : m_alloc(other.m_alloc),
+        m_value(std::exchange(other.m_value, nullptr)) {}
+
+  WTreeValueBox(const WTreeValueBox &other)
+      : m_alloc(other.m_alloc),
+        m_value(other.m_value ? create(*other.m_value) : nullptr) {}
+
+  // Allocators such as std::pmr::polymorphic_allocator cannot be assigned,
+  // so the box is rebuilt in place from other instead.
+  WTreeValueBox &operator=(WTreeValueBox &&other) noexcept {
+    if (this != &other) {
+      this->~WTreeValueBox();
+      ::new (static_cast<void *>(this)) WTreeValueBox(std::move(other));
+    }
+    return *this;
+  }
+
+  WTreeValueBox &operator=(const WTreeValueBox &) = delete;
+
+  ~WTreeValueBox() { reset(); }
+
+  Value &operator*() const { return *m_value; }
+
+private:
+  template <typename... Args> Value *create(Args &&...args) {
+    Value *value = allocator_traits::allocate(m_alloc, 1);
+    allocator_traits::construct(m_alloc, value, std::forward<Args>(args)...);
+    return value;
+  }
+
+  void reset() {
+    if (m_value == nullptr)
+      return;
+    allocator_traits::destroy(m_alloc, m_value);
+    allocator_traits::deallocate(m_alloc, m_value, 1);
+    m_value = nullptr;
+  }
+
+  [[no_unique_address]] allocator_type m_alloc;
+  Value *m_value;
+};
+
+} // namespace WTreeLib
+#endif
@@ -4,18 +4,22 @@
 #include "detail/unique_container.hpp"
 
 #include <memory>
+#include <memory_resource>
 
 namespace WTreeLib {
 
 // Map params: value_type == pair<const Key, Data>, stored in the node's values
 // array. Node size calculations use this pair size for slot layout.
 template <typename Key, typename Data, typename Compare, typename Alloc,
-          int TargetNodeSize, bool Unique = true>
+          int TargetNodeSize, bool Unique = true,
+          typename SearchPolicy = WTreeSearchPolicy<>>
 struct WTreeMapParams
     : public WTreeCommonParams<Key, Compare, Alloc, TargetNodeSize,
-                               std::pair<const Key, Data>, Unique> {
+                               std::pair<const Key, Data>, Unique,
+                               SearchPolicy> {
   using base = WTreeCommonParams<Key, Compare, Alloc, TargetNodeSize,
-                                 std::pair<const Key, Data>, Unique>;
+                                 std::pair<const Key, Data>, Unique,
+                                 SearchPolicy>;
   using typename base::value_type;
 
   using data_type = Data;
@@ -103,15 +107,19 @@ public:
   }
 };
 
-template <
-    typename Key, typename Value, int TargetNodeSize = WTREE_TARGET_NODE_BYTES,
-    typename Compare = std::less<Key>, typename Alloc = std::allocator<Key>>
+// SearchPolicy selects the node search algorithms, see WTreeSearchPolicy.
+template <typename Key, typename Value,
+          int TargetNodeSize = WTREE_TARGET_NODE_BYTES,
+          typename Compare = std::less<Key>,
+          typename Alloc = std::allocator<Key>,
+          typename SearchPolicy = WTreeSearchPolicy<>>
 class map
-    : public WTreeMapContainer<
-          WTree<WTreeMapParams<Key, Value, Compare, Alloc, TargetNodeSize>>> {
-  using self_type = map<Key, Value, TargetNodeSize, Compare, Alloc>;
-  using super_type = WTreeMapContainer<
-      WTree<WTreeMapParams<Key, Value, Compare, Alloc, TargetNodeSize>>>;
+    : public WTreeMapContainer<WTree<WTreeMapParams<
+          Key, Value, Compare, Alloc, TargetNodeSize, true, SearchPolicy>>> {
+  using self_type =
+      map<Key, Value, TargetNodeSize, Compare, Alloc, SearchPolicy>;
+  using super_type = WTreeMapContainer<WTree<WTreeMapParams<
+      Key, Value, Compare, Alloc, TargetNodeSize, true, SearchPolicy>>>;
 
 public:
   // Inherit all constructors from WTreeMapContainer.
@@ -136,6 +144,19 @@ public:
   bool operator<=(const self_type &rhs) const { return !(rhs < *this); }
 };
 
+namespace pmr {
+// A map whose nodes come from a std::pmr::memory_resource, see
+// WTreeLib::pmr::set. Values stored out of line come from the same
+// resource.
+template <typename Key, typename Value,
+          int TargetNodeSize = WTREE_TARGET_NODE_BYTES,
+          typename Compare = std::less<Key>,
+          typename SearchPolicy = WTreeSearchPolicy<>>
+using map =
+    WTreeLib::map<Key, Value, TargetNodeSize, Compare,
+                  std::pmr::polymorphic_allocator<Key>, SearchPolicy>;
+} // namespace pmr
+
 } // namespace WTreeLib
 
 #endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#ifndef _WTREE_CALIBRATE__H_
+#define _WTREE_CALIBRATE__H_
+
+#include "../detail/index.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <new>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace WTreeLib {
+
+/**
+ * Measures, on the running machine, the node size from which binary search
+ * beats linear search for the key type and comparator of a container.
+ *
+ * The crossover can either be applied at startup with calibrate() (nodes
+ * read it when WTREE_CALIBRATED_SEARCH_THRESHOLD is set), or be written as a
+ * WTreeSearchThreshold specialization by emit_threshold_specialization() from
+ * an offline run (see examples/calibrate_search.cpp).
+ */
+class WTreeCalibration {
+public:
+  struct Sample {
+    uint keys;        // Keys in the measured node.
+    double linear_ns; // Average time of one search.
+    double binary_ns;
+  };
+
+  /**
+   * @brief Times both searches over nodes of growing size.
+   *
+   * @param gen gen(i) returns the i-th key to build nodes from, in any
+   *        order; duplicates are dropped.
+   * @param max_keys Largest node measured (0 means kTargetK).
+   * @param searches Searches timed per node and method.
+   * @details The comparator of the container is default constructed. The
+   * linear search is vectorized where kAuto would vectorize it (kSimd).
+   */
+  template <typename Container, typename Generator>
+  static std::vector<Sample> measure(Generator gen, uint max_keys = 0,
+                                     uint searches = 20000) {
+    using node_type = typename Container::wtree_type::node_type;
+    using key_type = typename node_type::key_type;
+    using value_type = typename node_type::value_type;
+    using key_compare = typename node_type::key_compare;
+    using internal_fields = typename node_type::internal_fields;
+
+    if (max_keys == 0 || max_keys > node_type::kTargetK)
+      max_keys = node_type::kTargetK;
+
+    const key_compare comp{};
+    auto less = [&comp](const key_type &x, const key_type &y) {
+      return wtree_compare_keys(comp, x, y);
+    };
+    std::vector<key_type> pool;
+    for (uint i = 0; i < 2 * max_keys; ++i)
+      pool.push_back(gen(i));
+    std::sort(pool.begin(), pool.end(), less);
+    pool.erase(std::unique(pool.begin(), pool.end(),
+                           [&less](const key_type &x, const key_type &y) {
+                             return !less(x, y) && !less(y, x);
+                           }),
+               pool.end());
+    max_keys = std::min<uint>(max_keys, pool.size());
+
+    std::mt19937_64 rng(1);
+    std::vector<key_type> queries;
+    for (uint i = 0; i < searches && !pool.empty(); ++i)
+      queries.push_back(pool[rng() % pool.size()]);
+
+    // An internal node has room for kTargetK values.
+    void *storage = ::operator new(sizeof(internal_fields),
+                                   std::align_val_t(alignof(internal_fields)));
+    node_type *node =
+        node_type::init_internal(static_cast<internal_fields *>(storage));
+
+    std::vector<Sample> samples;
+    for (uint n = 4; n <= max_keys; n = next_size(n, max_keys)) {
+      // n keys spread over the whole pool.
+      for (uint i = 0; i < n; ++i) {
+        const key_type &k = pool[static_cast<size_t>(i) * pool.size() / n];
+        if constexpr (std::is_same_v<value_type, key_type>)
+          node->construct_value(i, k);
+        else
+          node->construct_value(i, std::piecewise_construct,
+                                std::forward_as_tuple(k),
+                                std::forward_as_tuple());
+      }
+      node->fields.size = n;
+
+      Sample sample{n, 0, 0};
+      sample.linear_ns = time_searches(queries, [&](const key_type &q) {
+        return node->template lower_bound_search<WTreeSearchMethod::kSimd>(
+            q, 0, n, comp);
+      });
+      sample.binary_ns = time_searches(queries, [&](const key_type &q) {
+        return node->template lower_bound_search<node_type::kBinaryMethod>(
+            q, 0, n, comp);
+      });
+      samples.push_back(sample);
+
+      for (uint i = 0; i < n; ++i)
+        node->destroy_value(static_cast<int>(i));
+      node->fields.size = 0;
+    }
+
+    ::operator delete(storage, std::align_val_t(alignof(internal_fields)));
+    return samples;
+  }
+
+  /**
+   * @brief Smallest measured size from which binary search is never slower.
+   * @return One past the largest size if linear search always won, and 0
+   * when there are no samples.
+   */
+  static uint crossover(const std::vector<Sample> &samples) {
+    uint threshold = samples.empty() ? 0 : samples.back().keys + 1;
+    for (size_t i = samples.size(); i > 0; --i) {
+      if (samples[i - 1].binary_ns > samples[i - 1].linear_ns)
+        break;
+      threshold = samples[i - 1].keys;
+    }
+    return threshold;
+  }
+
+  /**
+   * @brief Measures the crossover and makes it the runtime threshold of
+   * every container with the same key type and comparator.
+   * @return The new threshold.
+   */
+  template <typename Container, typename Generator>
+  static uint calibrate(Generator gen, uint max_keys = 0) {
+    using params_type = typename Container::wtree_type::params_type;
+    const uint threshold = crossover(measure<Container>(gen, max_keys));
+    params_type::calibrated_threshold::value = threshold;
+    return threshold;
+  }
+
+  // Writes a WTreeSearchThreshold specialization for the given key and
+  // comparator type names.
+  static void emit_threshold_specialization(FILE *out, const char *key_name,
+                                            const char *compare_name,
+                                            uint threshold) {
+    std::fprintf(out,
+                 "namespace WTreeLib {\n"
+                 "template <> struct WTreeSearchThreshold<%s, %s> {\n"
+                 "  static constexpr uint value = %u;\n"
+                 "};\n"
+                 "} // namespace WTreeLib\n",
+                 key_name, compare_name, threshold);
+  }
+
+private:
+  // Sizes grow by about 3/8 each step, and always end at max_keys.
+  static uint next_size(uint n, uint max_keys) {
+    const uint next = n + std::max<uint>(1, n / 2 - n / 8);
+    return n < max_keys && next > max_keys ? max_keys : next;
+  }
+
+  // Best of three rounds, in nanoseconds per search.
+  template <typename Key, typename Search>
+  static double time_searches(const std::vector<Key> &queries,
+                              const Search &search) {
+    if (queries.empty())
+      return 0;
+    // Unsigned, as positions may carry the kExactMatch bit and their sum
+    // only has to wrap.
+    volatile unsigned sink = 0;
+    double best = 0;
+    for (int round = 0; round < 3; ++round) {
+      const auto start = std::chrono::steady_clock::now();
+      unsigned acc = 0;
+      for (const Key &q : queries)
+        acc += static_cast<unsigned>(search(q));
+      sink = sink + acc;
+      const std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (round == 0 || elapsed.count() < best)
+        best = elapsed.count();
+    }
+    return best / queries.size();
+  }
+};
+
+} // namespace WTreeLib
+
+#endif
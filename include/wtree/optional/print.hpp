@@ -141,7 +141,7 @@ private:
   }
 
   std::string format_value_at(const node_type *node, int idx) const {
-    return format_value(node->fields.values[idx]);
+    return format_value(node->value(idx));
   }
 
   std::string format_node(const node_type *node, int indent) const {
@@ -324,7 +324,7 @@ private:
       std::cout << "{ ";
       for (int i = 0; i < std::min(2, static_cast<int>(node->fields.size) - 1);
            ++i) {
-        print_compact_node(node->fields.pointers[i], depth + 1);
+        print_compact_node(node->child(i), depth + 1);
       }
       std::cout << "} ";
     }
@@ -59,7 +59,26 @@ struct WTreeMemoryInstrument {
 
     total_bytes = num_nodes * NODE::kBasefieldsBytes +
                   unused_keycells * sizeof(T) +
-                  num_internals * (k_value - 1) * sizeof(void *);
+                  num_internals * (k_value - 1) *
+                      sizeof(typename NODE::child_handle_type) +
+                  num_internals * NODE::kChildWords * sizeof(uint64_t);
+    // Eytzinger search copy kept by each internal node.
+    if constexpr (NODE::kUseEytzingerLayout)
+      total_bytes += num_internals * sizeof(typename NODE::search_layout_type);
+    // Key column, one key per key cell.
+    if constexpr (NODE::kUseKeyColumn)
+      total_bytes +=
+          (keys + unused_keycells) * sizeof(typename NODE::key_type);
+    // Abbreviated keys, one per key cell.
+    if constexpr (NODE::kUseKeyPrefixes)
+      total_bytes += (keys + unused_keycells) * sizeof(uint64_t);
+    // Fence index of every node (about one key per kFenceStride cells).
+    if constexpr (NODE::kUseFences)
+      total_bytes += num_nodes * NODE::kFenceKeysOffset +
+                     (keys + unused_keycells) / NODE::kFenceStride * sizeof(T);
+    // Learned position model of every node.
+    if constexpr (NODE::kUseLearnedModel)
+      total_bytes += num_nodes * sizeof(typename NODE::node_model);
     average_bytes_per_key = keys > 0 ? (double)total_bytes / keys : total_bytes;
   };
 
@@ -124,7 +143,8 @@ public:
   all the allocated pointer cells.
   */
   static void check_statistics(wtree_type &sref, WTreeMemoryInstrument &reg) {
-    if (sref.root() == nullptr)
+    if (sref.root() == nullptr ||
+        wtree_type::manager_type::is_empty_root(sref.root()))
       return;
     _check_statistics(reg, sref.root(), 0);
     reg.evaluate<Params, node_type>();
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <sys/types.h>
 #include <type_traits>
+#include <vector>
 
 namespace WTreeLib {
 
@@ -38,7 +39,7 @@ public:
     using field_type = typename node_type::field_type;
     using key_type = typename node_type::key_type;
 
-    std::vector<node_type *> path(it.ascendants);
+    std::vector<node_type *> path(it.ascendants.begin(), it.ascendants.end());
     path.push_back(it.node);
 
     bool is_correct = true;
@@ -126,7 +127,7 @@ public:
     for (size_t i_node = 0; i_node < it.ascendants.size(); ++i_node) {
       node_type *node = it.ascendants[i_node];
       for (field_type i = 0; i < node->size(); ++i) {
-        const value_type &entry = node->fields.values[i];
+        const value_type &entry = node->value(i);
         if (!validator(entry.first, entry.second)) {
           if constexpr (std::is_arithmetic_v<key_type>) {
             printf("[VERIFY ERROR :: Value] Value validation "
@@ -146,7 +147,7 @@ public:
     // Validate the leaf node the iterator points into.
     node_type *leaf = it.node;
     for (field_type i = 0; i < leaf->size(); ++i) {
-      const value_type &entry = leaf->fields.values[i];
+      const value_type &entry = leaf->value(i);
       if (!validator(entry.first, entry.second)) {
         if constexpr (std::is_arithmetic_v<key_type>) {
           printf("[VERIFY ERROR :: Value] Value validation failed "
@@ -182,6 +183,27 @@ private:
       return false;
     }
 
+    if constexpr (node_type::kUseKeyColumn) {
+      for (field_type i = 0; i < node->size(); ++i) {
+        if (!(node->key(i) == Params::get_key(node->value(i)))) {
+          printf("[VERIFY ERROR :: Key column] Stale key at index %lu\n",
+                 (ulong)i);
+          return false;
+        }
+      }
+    }
+
+    if (node->is_internal()) {
+      for (size_t i = 0; i < node_type::kTargetK - 1; ++i) {
+        const bool bit = (node->fields.child_bits[i / 64] >> (i % 64)) & 1;
+        if (bit != (node->child(i) != nullptr)) {
+          printf("[VERIFY ERROR :: Children] Stale bitmap at index %lu\n",
+                 (ulong)i);
+          return false;
+        }
+      }
+    }
+
     for (field_type i = 0; i < node->size() - 1; ++i) {
       if (!(node->key(i) < node->key(i + 1))) {
         if constexpr (std::is_arithmetic_v<key_type>) {
@@ -259,6 +281,9 @@ public:
 
     if (updateSize)
       modify_adapter::decrease_size(wtree, wtree.mutable_root()->size());
+    // Rule tests expect the internal root a tree gets once it fills up.
+    if (WTree<Params>::manager_type::is_empty_root(wtree.root()))
+      wtree.mutable_root() = wtree.manager()->new_internal_node();
     if (wtree.mutable_root()->capacity() < size) {
       wtree.mutable_root() = wtree.manager()->new_leaf_node(size);
     }
@@ -271,6 +296,7 @@ public:
       wtree.mutable_root()->fields.values[i] = left;
 
     wtree.mutable_root()->fields.size = size;
+    wtree.mutable_root()->refresh_search_copies();
     if (updateSize)
       modify_adapter::increase_size(wtree, size);
     return true;
@@ -287,6 +313,9 @@ public:
 
     if (updateSize)
       modify_adapter::decrease_size(wtree, (*u)->size());
+    // Rule tests expect the internal root a tree gets once it fills up.
+    if (WTree<Params>::manager_type::is_empty_root(*u))
+      (*u) = wtree.mutable_root() = wtree.manager()->new_internal_node();
     if ((*u)->fields.capacity < size) {
       (*u) = wtree.manager()->new_leaf_node(size);
     }
@@ -299,6 +328,7 @@ public:
       (*u)->fields.values[i] = left;
 
     (*u)->fields.size = size;
+    (*u)->refresh_search_copies();
     if (updateSize)
       modify_adapter::increase_size(wtree, size);
     return true;
@@ -313,16 +343,17 @@ public:
     assert(node->fields.is_internal);
     assert(index < node_type::kTargetK - 1);
 
-    node_type *u = node->fields.pointers[index];
+    node_type *u = node->child(index);
     if (!u)
       u = wtree.manager()->new_leaf_node(size);
     else if (u->fields.capacity < size)
       u = wtree.manager()->grow_leaf_to_size(u, size);
-    node->fields.pointers[index] = u;
 
-    return fill_node(wtree, &(node->fields.pointers[index]), size,
-                     node->fields.values[index],
-                     node->fields.values[index + 1]);
+    const bool filled =
+        fill_node(wtree, &u, size, node->fields.values[index],
+                  node->fields.values[index + 1]);
+    node->set_child(index, u);
+    return filled;
   }
 
   // template <typename Params>
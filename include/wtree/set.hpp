@@ -4,16 +4,18 @@
 #include "detail/unique_container.hpp"
 
 #include <memory>
+#include <memory_resource>
 
 namespace WTreeLib {
 
 // Set params: value_type == Key, stored directly in the node's values array.
 template <typename Key, typename Compare, typename Alloc, int TargetNodeSize,
-          bool Unique = true>
-struct WTreeSetParams : public WTreeCommonParams<Key, Compare, Alloc,
-                                                 TargetNodeSize, Key, Unique> {
-  using base =
-      WTreeCommonParams<Key, Compare, Alloc, TargetNodeSize, Key, Unique>;
+          bool Unique = true, typename SearchPolicy = WTreeSearchPolicy<>>
+struct WTreeSetParams
+    : public WTreeCommonParams<Key, Compare, Alloc, TargetNodeSize, Key,
+                               Unique, SearchPolicy> {
+  using base = WTreeCommonParams<Key, Compare, Alloc, TargetNodeSize, Key,
+                                 Unique, SearchPolicy>;
   using typename base::value_type;
 
   // No mapped data for sets.
@@ -24,19 +26,34 @@ struct WTreeSetParams : public WTreeCommonParams<Key, Compare, Alloc,
   static const Key &get_key(const value_type &x) { return x; }
 };
 
+// SearchPolicy selects the node search algorithms, e.g.
+// WTreeSearchPolicy<WTreeSearchMethod::kInterpolation> for near-uniform
+// integer keys.
 template <typename Key, int TargetNodeSize = WTREE_TARGET_NODE_BYTES,
           typename Compare = std::less<Key>,
-          typename Alloc = std::allocator<Key>>
-class set : public WTreeUniqueContainer<
-                WTree<WTreeSetParams<Key, Compare, Alloc, TargetNodeSize>>> {
-  using super_type = WTreeUniqueContainer<
-      WTree<WTreeSetParams<Key, Compare, Alloc, TargetNodeSize>>>;
+          typename Alloc = std::allocator<Key>,
+          typename SearchPolicy = WTreeSearchPolicy<>>
+class set
+    : public WTreeUniqueContainer<WTree<WTreeSetParams<
+          Key, Compare, Alloc, TargetNodeSize, true, SearchPolicy>>> {
+  using super_type = WTreeUniqueContainer<WTree<WTreeSetParams<
+      Key, Compare, Alloc, TargetNodeSize, true, SearchPolicy>>>;
 
 public:
   // Inherit all constructors from WTreeUniqueContainer.
   using super_type::super_type;
 };
 
+namespace pmr {
+// A set whose nodes come from a std::pmr::memory_resource, e.g. a
+// std::pmr::monotonic_buffer_resource for short-lived indexes.
+template <typename Key, int TargetNodeSize = WTREE_TARGET_NODE_BYTES,
+          typename Compare = std::less<Key>,
+          typename SearchPolicy = WTreeSearchPolicy<>>
+using set = WTreeLib::set<Key, TargetNodeSize, Compare,
+                          std::pmr::polymorphic_allocator<Key>, SearchPolicy>;
+} // namespace pmr
+
 } // namespace WTreeLib
 
 #endif
\ No newline at end of file
@@ -1,11 +1,15 @@
 #ifndef _WTREE_TEST_ERASE_RULES_H_
 #define _WTREE_TEST_ERASE_RULES_H_
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <ctime>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <set>
+#include <vector>
 #include <sys/types.h>
 
 #include "../shared.hpp"
@@ -48,6 +52,7 @@ bool Test_only_root(Printer printer = Printer()) {
     return result;
 
   result = WUtils::fill_root_node(*wt, k_value, 0, 10000);
+  node = wt->root();
   assert(result);
   printer.print_tree(node);
 
@@ -62,6 +67,7 @@ bool Test_only_root(Printer printer = Printer()) {
     return result;
 
   result = WUtils::fill_root_node(*wt, k_value, 0, 10000);
+  node = wt->root();
   assert(result);
   printer.print_tree(node);
 
@@ -119,6 +125,7 @@ bool Test_erase_inside_root_children(Printer printer = Printer()) {
   WTREE_TEST_PREAMBLE(int);
 
   result = WUtils::fill_root_node(*wt, k_value, 0, 10000);
+  node = wt->root();
   assert(result);
 
   // == Using first child
@@ -178,6 +185,7 @@ bool Test_internal_erase_replacing_from_left(Printer printer = Printer()) {
   job_title(job_str);
 
   result = WUtils::fill_root_node(*wt, k_value, 0, 10000);
+  node = wt->root();
   assert(result);
   curr_size = k_value;
 
@@ -209,6 +217,7 @@ bool Test_internal_erase_replacing_from_left(Printer printer = Printer()) {
   curr_size = 0;
   result =
       WUtils::fill_root_node(*wt, k_value, 0, numeric_limits<KeyType>::max());
+  node = wt->root();
   curr_size += k_value;
   assert(result);
   result = WUtils::fill_child(*wt, node, 0, k_value);
@@ -239,6 +248,7 @@ bool Test_internal_erase_replacing_from_left(Printer printer = Printer()) {
   curr_size = 0;
   result =
       WUtils::fill_root_node(*wt, k_value, 0, numeric_limits<KeyType>::max());
+  node = wt->root();
   curr_size += k_value;
   assert(result);
   result = WUtils::fill_child(*wt, node, 0, k_value);
@@ -279,6 +289,7 @@ bool Test_internal_erase_replacing_from_right(Printer printer = Printer()) {
   job_title(job_str);
 
   result = WUtils::fill_root_node(*wt, k_value, 0, 10000);
+  node = wt->root();
   curr_size = k_value;
   assert(result);
 
@@ -312,6 +323,7 @@ bool Test_internal_erase_replacing_from_right(Printer printer = Printer()) {
 
   result =
       WUtils::fill_root_node(*wt, k_value, 0, numeric_limits<KeyType>::max());
+  node = wt->root();
   curr_size += k_value;
   assert(result);
   result = WUtils::fill_child(*wt, node, last_child_index, k_value);
@@ -344,6 +356,7 @@ bool Test_internal_erase_replacing_from_right(Printer printer = Printer()) {
 
   result =
       WUtils::fill_root_node(*wt, k_value, 0, numeric_limits<KeyType>::max());
+  node = wt->root();
   curr_size += k_value;
   assert(result);
   result = WUtils::fill_child(*wt, node, last_child_index, k_value);
@@ -379,6 +392,210 @@ bool Test_internal_erase_replacing_from_right(Printer printer = Printer()) {
 
   return result;
 }
+
+/**
+ * Erases every value of a random tree in random order, so that each erase
+ * path (leaf shift, replacement from the left or right descendants, child
+ * removal) runs on values that own something. After every erase the tree
+ * must hold exactly as many live values as its size.
+ */
+bool Test_erase_releases_values() {
+  using CountedSet = WTreeLib::set<CountedValue, 128>;
+  string job_str = "Erased values are destroyed, not leaked.";
+  job_title(job_str);
+  CountedValue::reset();
+  bool result = true;
+  {
+    CountedSet storage;
+    std::set<int> expected;
+    std::mt19937 rng(11);
+    for (int i = 0; i < 3000; ++i) {
+      const int x = static_cast<int>(rng() % 100000);
+      storage.insert(CountedValue(x));
+      expected.insert(x);
+    }
+
+    vector<int> order(expected.begin(), expected.end());
+    std::shuffle(order.begin(), order.end(), rng);
+    for (int x : order) {
+      result &= storage.erase(CountedValue(x)) == 1;
+      expected.erase(x);
+      result &= storage.size() == expected.size() &&
+                CountedValue::live == static_cast<long>(storage.size()) &&
+                CountedValue::bad_destroys == 0;
+      if (!result) {
+        cout << "Out of sync after erasing " << x << "\n";
+        break;
+      }
+    }
+  }
+  result &= CountedValue::live == 0 && CountedValue::bad_destroys == 0;
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
+
+/**
+ * clear() must destroy the values of every node, the root included, both
+ * when the root is the only node and when the tree has grown below it.
+ */
+bool Test_clear_releases_values() {
+  using CountedSet = WTreeLib::set<CountedValue, 128>;
+  string job_str = "Clear destroys the root and descendant values.";
+  job_title(job_str);
+  CountedValue::reset();
+  bool result = true;
+  {
+    CountedSet storage;
+    for (int i = 0; i < 4; ++i)
+      storage.insert(CountedValue(i));
+    storage.clear();
+    result &= storage.size() == 0 && CountedValue::live == 0;
+
+    for (int i = 0; i < 3000; ++i)
+      storage.insert(CountedValue(i * 7919 % 3001));
+    storage.clear();
+    result &= storage.size() == 0 && CountedValue::live == 0;
+
+    storage.insert(CountedValue(1));
+    result &= storage.size() == 1 && CountedValue::live == 1;
+  }
+  result &= CountedValue::live == 0 && CountedValue::bad_destroys == 0;
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
+
+/**
+ * Draining a tree from one end pulls the smallest (or greatest) value of a
+ * subtree up into its ancestor over and over, down to descendants that
+ * hold a single value. That value leaves with its node and must be
+ * destroyed once, not again when the emptied node is deleted.
+ */
+bool Test_erase_from_ends_destroys_once() {
+  using CountedSet = WTreeLib::set<CountedValue, 128>;
+  string job_str = "Draining from either end destroys each value once.";
+  job_title(job_str);
+  CountedValue::reset();
+  bool result = true;
+  const int n = 400;
+  for (bool from_front : {true, false}) {
+    CountedSet storage;
+    for (int i = 0; i < n; ++i)
+      storage.insert(CountedValue(i));
+
+    for (int i = 0; i < n; ++i) {
+      const int x = from_front ? i : n - 1 - i;
+      result &= storage.erase(CountedValue(x)) == 1;
+      result &= CountedValue::live == static_cast<long>(storage.size()) &&
+                CountedValue::bad_destroys == 0;
+      if (!result) {
+        cout << "Out of sync after erasing " << x << "\n";
+        break;
+      }
+    }
+  }
+  result &= CountedValue::live == 0 && CountedValue::bad_destroys == 0;
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
+
+/**
+ * Erasing a value of an internal node pulls its replacement out of a
+ * descendant. When the path to that replacement ends at an internal node,
+ * the node is rebuilt as a leaf first, and the rebuild must only copy live
+ * slots. Strided inserts and middle-out erases hit that case often.
+ */
+bool Test_erase_rebuilds_descendant_before_moving() {
+  using CountedSet = WTreeLib::set<CountedValue, 128>;
+  string job_str = "Replacement is taken after the descendant is rebuilt.";
+  job_title(job_str);
+  CountedValue::reset();
+  bool result = true;
+  {
+    const int n = 400;
+    CountedSet storage;
+    std::set<int> expected;
+    for (int i = 0; i < n; ++i) {
+      storage.insert(CountedValue(i * 37 % n));
+      expected.insert(i * 37 % n);
+    }
+
+    for (int i = 0; i < n && result; ++i) {
+      const int x = i % 2 ? n / 2 + i / 2 : n / 2 - 1 - i / 2;
+      result &= storage.erase(CountedValue(x)) == 1;
+      expected.erase(x);
+      result &= CountedValue::bad_destroys == 0 &&
+                CountedValue::live == static_cast<long>(storage.size());
+      auto it = storage.begin();
+      for (int y : expected) {
+        result &= it != storage.end() && it->value == y;
+        if (!result)
+          break;
+        ++it;
+      }
+      if (!result)
+        cout << "Out of sync after erasing " << x << "\n";
+    }
+  }
+  result &= CountedValue::live == 0 && CountedValue::bad_destroys == 0;
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
+
+/**
+ * Erases remove children from internal nodes, as descendants empty out or
+ * are merged into leaves. After each batch of random erases, the bitmap
+ * scans for the next or previous child must agree with the children from
+ * every index.
+ */
+bool Test_child_bitmap_after_merges() {
+  WTREE_TEST_PREAMBLE(int);
+
+  job_str = "Child bitmap scans agree with the children after merges.";
+  job_title(job_str);
+  vector<int> keys(3000);
+  for (int i = 0; i < 3000; ++i)
+    keys[i] = i * 7;
+  std::mt19937 rng(13);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  for (int x : keys)
+    storage.insert(x);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  for (size_t i = 0; i < keys.size() && result; ++i) {
+    result &= storage.erase(keys[i]) == 1;
+    if (i % 25 == 0)
+      result &= child_scans_match(wt->root()) &&
+                WTreeLib::WTreeValidationUtils::validate_wtree(
+                    *wt, static_cast<long>(storage.size()));
+  }
+  result &= storage.empty();
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
 } // namespace EraseRulesNamespace
 
 #endif
@@ -41,7 +41,11 @@ int main() {
   result &= Test_erase_root_children_with_one_value(printer) &&
             Test_erase_inside_root_children(printer) &&
             Test_internal_erase_replacing_from_left(printer) &&
-            Test_internal_erase_replacing_from_right(printer);
+            Test_internal_erase_replacing_from_right(printer) &&
+            Test_erase_releases_values() && Test_clear_releases_values() &&
+            Test_erase_from_ends_destroys_once() &&
+            Test_erase_rebuilds_descendant_before_moving() &&
+            Test_child_bitmap_after_merges();
   if (!result) {
     test_incorrect(title);
     return EXIT_FAILURE;
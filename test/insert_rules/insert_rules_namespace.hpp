@@ -5,12 +5,16 @@
 #include <cstdio>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <set>
+#include <string>
 #include <sys/types.h>
 
 #include "../shared.hpp"
 
 #include "../../include/wtree/optional/print.hpp"
 #include "../../include/wtree/optional/utils.hpp"
+#include "../../include/wtree/map.hpp"
 #include "../../include/wtree/set.hpp"
 
 namespace InsertRulesNamespace {
@@ -123,7 +127,7 @@ bool Test_Slides(Printer printer = Printer()) {
   job_str = "Setup slide test - create child node.";
   job_title(job_str);
   ulong mid = k_size / 2;
-  node->fields.pointers[mid] = wt->manager()->new_leaf_node(k_size);
+  node->set_child(mid, wt->manager()->new_leaf_node(k_size));
   result = WUtils::fill_child(*wt, wt->root(), mid, k_size);
   assert(result);
   total_size += k_size;
@@ -199,6 +203,103 @@ bool Test_Split(Printer printer = Printer()) {
   return false;
 }
 
+/**
+ * Inserts that land inside a node shift its values by one slot, and slides
+ * shift whole runs between siblings. Every shifted value must be moved
+ * exactly once: the tree holds as many live values as its size.
+ */
+bool Test_Shifts_Release_Values() {
+  using CountedSet = WTreeLib::set<CountedValue, 128>;
+
+  job_title("Shifted values are moved, not leaked.");
+  CountedValue::reset();
+  bool result = true;
+  {
+    CountedSet storage;
+    std::set<int> expected;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 3000; ++i) {
+      const int x = static_cast<int>(rng() % 100000);
+      storage.insert(CountedValue(x));
+      expected.insert(x);
+    }
+
+    result &= storage.size() == expected.size() &&
+              CountedValue::live == static_cast<long>(storage.size());
+    auto it = storage.begin();
+    for (int x : expected) {
+      result &= it != storage.end() && it->value == x;
+      if (!result)
+        break;
+      ++it;
+    }
+  }
+  result &= CountedValue::live == 0 && CountedValue::bad_destroys == 0;
+
+  if (!result) {
+    job_bad_result("Live values do not match the tree contents.");
+    return false;
+  }
+  job_correct_result("Live values match the tree contents.");
+  return true;
+}
+
+/**
+ * Compare-to keys report a miss as a negative code that shares bits with
+ * kExactMatch, so a unique insert must test for the exact code. Every
+ * distinct string key is kept, and duplicates are still rejected.
+ */
+bool Test_Unique_String_Keys() {
+  using StringMap = WTreeLib::map<string, int>;
+
+  job_title("Distinct string keys are all inserted.");
+  StringMap storage;
+  bool result = true;
+  for (int i = 0; i < 1000; ++i)
+    result &= storage.insert({"key-" + std::to_string(i), i}).second;
+  result &= storage.size() == 1000;
+  for (int i = 0; i < 1000; ++i) {
+    auto it = storage.find("key-" + std::to_string(i));
+    result &= it != storage.end() && it->second == i;
+  }
+  result &= !storage.insert({"key-500", -1}).second && storage.size() == 1000;
+
+  if (!result) {
+    job_bad_result("String map lost or duplicated keys.");
+    return false;
+  }
+  job_correct_result("String map holds every distinct key once.");
+  return true;
+}
+
+/**
+ * Internal nodes track their children in a bitmap, which the scans for the
+ * next or previous child read instead of the child slots. Splits hand
+ * children to new nodes, so after each batch of random inserts the scans
+ * must agree with the children from every index.
+ */
+bool Test_Child_Bitmap_After_Splits() {
+  WTREE_TEST_PREAMBLE(int);
+
+  job_str = "Child bitmap scans agree with the children after splits.";
+  job_title(job_str);
+  std::mt19937 rng(11);
+  for (int i = 1; i <= 3000 && result; ++i) {
+    storage.insert(static_cast<int>(rng() % 100000));
+    if (i % 25 == 0)
+      result &= child_scans_match(wt->root()) &&
+                WTreeLib::WTreeValidationUtils::validate_wtree(
+                    *wt, static_cast<long>(storage.size()));
+  }
+
+  if (!result) {
+    job_bad_result(job_str);
+    return false;
+  }
+  job_correct_result(job_str);
+  return true;
+}
+
 bool Test_all_Rules(Printer printer = Printer()) {
   WTREE_TEST_PREAMBLE(int);
 
@@ -217,6 +318,24 @@ bool Test_all_Rules(Printer printer = Printer()) {
     return false;
   }
 
+  result = Test_Unique_String_Keys();
+  if (!result) {
+    job_bad_result("String key insertion test failed.");
+    return false;
+  }
+
+  result = Test_Shifts_Release_Values();
+  if (!result) {
+    job_bad_result("Value lifetime test failed.");
+    return false;
+  }
+
+  result = Test_Child_Bitmap_After_Splits();
+  if (!result) {
+    job_bad_result("Child bitmap test failed.");
+    return false;
+  }
+
   job_correct_result("All insertion rules tested successfully.");
   return true;
 }
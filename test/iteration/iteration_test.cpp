@@ -0,0 +1,317 @@
+#include "../shared.hpp"
+
+#include "../../include/wtree/map.hpp"
+#include "../../include/wtree/optional/utils.hpp"
+#include "../../include/wtree/set.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+const string title = "Iteration Test";
+
+using namespace std;
+using namespace WTreeLib;
+
+// The path stack keeps its entries across spilling to the heap, copies and
+// moves. Keys inserted in order make paths deeper than the inline stack,
+// which lookups and scans then go through; random keys stay inline.
+template <int NodeBytes>
+bool check_iterator_paths(TestResults &results, const string &name) {
+  WTreePathStack<int, 4> stack;
+  for (int i = 0; i < 100; ++i)
+    stack.push_back(i);
+  WTreePathStack<int, 4> copy(stack);
+  WTreePathStack<int, 4> moved(std::move(copy));
+  moved.pop_back();
+  bool ok = stack.spilled() && copy.empty() && moved.size() == 99 &&
+            std::equal(moved.begin(), moved.end(), stack.begin());
+  for (int i = 0; ok && i < 100; ++i)
+    ok = stack[i] == i;
+  if (!ok) {
+    results.fail(name, "path stack");
+    return false;
+  }
+
+  using SetType = WTreeLib::set<uint64_t, NodeBytes>;
+  using const_iterator = typename SetType::const_iterator;
+  constexpr size_t kInline = SetType::iterator::kInlinePathDepth;
+  SetType deep;
+  const uint64_t count = 4000;
+  for (uint64_t v = 0; v < count; ++v)
+    deep.insert(2 * v);
+  bool spilled = false;
+  for (uint64_t v = 0; ok && v < count; v += 7) {
+    auto it = deep.find(2 * v);
+    spilled = spilled || it.ascendants.size() > kInline;
+    const_iterator next(it);
+    ++next;
+    auto bound = deep.lower_bound(2 * v + 1);
+    ok = it != deep.end() && *it == 2 * v &&
+         (v + 1 == count ? next == deep.cend() && bound == deep.end()
+                         : *next == 2 * v + 2 && *bound == 2 * v + 2);
+  }
+  uint64_t expected = 0;
+  for (auto it = deep.begin(); ok && it != deep.end(); ++it, expected += 2)
+    ok = *it == expected;
+  for (auto it = deep.end(); ok && it != deep.begin();)
+    ok = *--it == (expected -= 2);
+  if (!ok || !spilled || expected != 0) {
+    results.fail(name, "deep paths");
+    return false;
+  }
+
+  SetType wide;
+  std::mt19937_64 rng(41);
+  std::vector<uint64_t> keys(100000);
+  for (uint64_t &v : keys) {
+    v = rng();
+    wide.insert(v);
+  }
+  for (size_t i = 0; ok && i < keys.size(); i += 11) {
+    const auto it = wide.find(keys[i]);
+    ok = it != wide.end() && *it == keys[i] && !it.ascendants.spilled() &&
+         !it.move_indexes.spilled();
+  }
+  if (!ok) {
+    results.fail(name, "inline paths");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Block scans hand out every value in [lo, hi) once and in order, as
+// runs of several values unless the values are stored out of line, and
+// stop when the callback returns false. Ordered keys make deep trees.
+template <typename ContainerType, typename CheckValue>
+bool check_block_scans(TestResults &results, const string &name,
+                       bool ordered, CheckValue check_value) {
+  using params_type = typename ContainerType::wtree_type::params_type;
+  using value_type = typename ContainerType::value_type;
+  using block_type = typename ContainerType::block_type;
+  ContainerType storage;
+  std::set<uint32_t> expected;
+  std::mt19937_64 rng(43);
+  for (uint32_t i = 0; i < 20000; ++i) {
+    const uint32_t k = ordered ? 3 * i : static_cast<uint32_t>(rng());
+    if constexpr (std::is_same_v<value_type, uint32_t>)
+      storage.insert(k);
+    else
+      storage.insert({k, typename value_type::second_type(k)});
+    expected.insert(k);
+  }
+
+  vector<uint32_t> scanned;
+  size_t blocks = 0;
+  const auto collect = [&](block_type block) {
+    ++blocks;
+    for (const value_type &v : block) {
+      if (!check_value(v))
+        return false;
+      scanned.push_back(params_type::get_key(v));
+    }
+    return true;
+  };
+  storage.for_each_block(collect);
+  constexpr bool kInline = !params_type::kUseOutOfLineValues;
+  if (!std::equal(scanned.begin(), scanned.end(), expected.begin(),
+                  expected.end()) ||
+      (kInline ? 2 * blocks > expected.size() : blocks != expected.size())) {
+    results.fail(name, "full scan");
+    return false;
+  }
+
+  for (int q = 0; q < 300; ++q) {
+    uint32_t lo = static_cast<uint32_t>(rng());
+    uint32_t hi = static_cast<uint32_t>(rng());
+    if (ordered) {
+      lo %= 3 * 20000 + 10;
+      hi %= 3 * 20000 + 10;
+    }
+    if (q % 10 == 0)
+      hi = lo;
+    if (hi < lo)
+      std::swap(lo, hi);
+    scanned.clear();
+    storage.for_each_block(lo, hi, collect);
+    if (!std::equal(scanned.begin(), scanned.end(), expected.lower_bound(lo),
+                    expected.lower_bound(hi))) {
+      results.fail(name, "range scan");
+      return false;
+    }
+  }
+
+  scanned.clear();
+  storage.for_each_block([&](block_type block) {
+    for (const value_type &v : block) {
+      scanned.push_back(params_type::get_key(v));
+      if (scanned.size() == 1000)
+        return false;
+    }
+    return true;
+  });
+  if (scanned.size() != 1000 ||
+      !std::equal(scanned.begin(), scanned.end(), expected.begin())) {
+    results.fail(name, "stopped scan");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Reverse iterators walk the values backwards in place, from rbegin() or
+// from the last value below a key, and round-trip through base(). Reverse
+// block scans hand out the same values as the forward ones, last first.
+template <typename ContainerType>
+bool check_reverse_scans(TestResults &results, const string &name,
+                         bool ordered) {
+  using params_type = typename ContainerType::wtree_type::params_type;
+  using value_type = typename ContainerType::value_type;
+  using block_type = typename ContainerType::block_type;
+  using reverse_iterator = typename ContainerType::reverse_iterator;
+  using const_reverse_iterator =
+      typename ContainerType::const_reverse_iterator;
+  ContainerType storage;
+  bool ok = storage.rbegin() == storage.rend() &&
+            storage.crbegin() == storage.crend();
+  std::set<uint32_t> expected;
+  std::mt19937_64 rng(47);
+  for (uint32_t i = 0; i < 20000; ++i) {
+    const uint32_t k = ordered ? 3 * i : static_cast<uint32_t>(rng());
+    if constexpr (std::is_same_v<value_type, uint32_t>)
+      storage.insert(k);
+    else
+      storage.insert({k, typename value_type::second_type(k)});
+    expected.insert(k);
+  }
+
+  auto want = expected.rbegin();
+  for (auto it = storage.rbegin(); ok && it != storage.rend(); ++it, ++want)
+    ok = want != expected.rend() && params_type::get_key(*it) == *want;
+  ok = ok && want == expected.rend();
+  for (auto it = storage.rend(); ok && it != storage.rbegin();)
+    ok = params_type::get_key(*--it) == *--want;
+  if (!ok) {
+    results.fail(name, "reverse iteration");
+    return false;
+  }
+
+  vector<uint32_t> scanned;
+  const auto collect = [&](block_type block) {
+    for (auto v = block.rbegin(); v != block.rend(); ++v)
+      scanned.push_back(params_type::get_key(*v));
+  };
+  for (int q = 0; ok && q < 300; ++q) {
+    uint32_t lo = static_cast<uint32_t>(rng());
+    uint32_t hi = static_cast<uint32_t>(rng());
+    if (ordered) {
+      lo %= 3 * 20000 + 10;
+      hi %= 3 * 20000 + 10;
+    }
+    if (q % 10 == 0)
+      hi = lo;
+    if (hi < lo)
+      std::swap(lo, hi);
+
+    const reverse_iterator from(storage.lower_bound(hi));
+    const const_reverse_iterator cfrom = from;
+    const auto below = std::make_reverse_iterator(expected.lower_bound(hi));
+    ok = (below == expected.rend()
+              ? from == storage.rend()
+              : cfrom != storage.crend() && cfrom.key() == *below) &&
+         from.base() == storage.lower_bound(hi);
+    if constexpr (!std::is_same_v<value_type, uint32_t>)
+      if (ok && from != storage.rend())
+        ok = from->second == typename value_type::second_type(from->first);
+
+    scanned.clear();
+    storage.for_each_block_reverse(lo, hi, collect);
+    ok = ok && std::equal(scanned.begin(), scanned.end(),
+                          std::make_reverse_iterator(expected.lower_bound(hi)),
+                          std::make_reverse_iterator(expected.lower_bound(lo)));
+    scanned.clear();
+    storage.for_each_block_reverse(hi, collect);
+    ok = ok && std::equal(scanned.begin(), scanned.end(), below,
+                          expected.rend());
+  }
+  if (!ok) {
+    results.fail(name, "reverse range scan");
+    return false;
+  }
+
+  scanned.clear();
+  storage.for_each_block_reverse(collect);
+  if (!std::equal(scanned.begin(), scanned.end(), expected.rbegin(),
+                  expected.rend())) {
+    results.fail(name, "reverse full scan");
+    return false;
+  }
+
+  // The latest 1000 values before a key.
+  const uint32_t hi = *std::next(expected.begin(), expected.size() / 2);
+  scanned.clear();
+  storage.for_each_block_reverse(hi, [&](block_type block) {
+    for (auto v = block.rbegin(); v != block.rend(); ++v) {
+      scanned.push_back(params_type::get_key(*v));
+      if (scanned.size() == 1000)
+        return false;
+    }
+    return true;
+  });
+  if (scanned.size() != 1000 ||
+      !std::equal(scanned.begin(), scanned.end(),
+                  std::make_reverse_iterator(expected.lower_bound(hi)))) {
+    results.fail(name, "stopped reverse scan");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+int main() {
+  TestResults results;
+
+  TestPrinting::job_title("Iterator paths.");
+  check_iterator_paths<128>(results, "set<uint64_t, 128>");
+  check_iterator_paths<512>(results, "set<uint64_t, 512>");
+
+  TestPrinting::job_title("Block scans.");
+  const auto any_value = [](const auto &) { return true; };
+  const auto derived_payload = [](const auto &v) {
+    return v.second == LargePayload(v.first);
+  };
+  check_block_scans<WTreeLib::set<uint32_t, 512>>(
+      results, "set<uint32_t, 512>", false, any_value);
+  check_block_scans<WTreeLib::set<uint32_t, 512>>(
+      results, "ordered set<uint32_t, 512>", true, any_value);
+  check_block_scans<WTreeLib::map<uint32_t, int, 4096>>(
+      results, "map<uint32_t, int, 4096>", false,
+      [](const auto &v) { return v.second == static_cast<int>(v.first); });
+  check_block_scans<WTreeLib::map<uint32_t, LargePayload, 1024>>(
+      results, "map<uint32_t, large, 1024>", false, derived_payload);
+
+  TestPrinting::job_title("Reverse scans.");
+  check_reverse_scans<WTreeLib::set<uint32_t, 512>>(
+      results, "set<uint32_t, 512>", false);
+  check_reverse_scans<WTreeLib::set<uint32_t, 128>>(
+      results, "ordered set<uint32_t, 128>", true);
+  check_reverse_scans<WTreeLib::map<uint32_t, int, 4096>>(
+      results, "map<uint32_t, int, 4096>", false);
+  check_reverse_scans<WTreeLib::map<uint32_t, LargePayload, 1024>>(
+      results, "map<uint32_t, large, 1024>", false);
+
+  results.summary();
+  if (!results.all_passed()) {
+    TestPrinting::test_incorrect(title);
+    return EXIT_FAILURE;
+  }
+  TestPrinting::test_correct(title);
+  return 0;
+}
@@ -0,0 +1,365 @@
+#include "../shared.hpp"
+
+#include "../../include/wtree/map.hpp"
+#include "../../include/wtree/optional/utils.hpp"
+#include "../../include/wtree/set.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+const string title = "Lookup Test";
+
+using namespace std;
+using namespace WTreeLib;
+
+// Bytes of every node of a tree, to compare before and after lookups.
+template <typename Tree> vector<vector<char>> node_bytes(Tree &tree) {
+  using node_type = typename Tree::node_type;
+  vector<vector<char>> bytes;
+  for_each_node(tree.root(), [&bytes](const node_type *node) {
+    const size_t n = node->is_internal()
+                         ? sizeof(typename node_type::internal_fields)
+                         : node_type::leaf_bytes(node->capacity());
+    const char *p = reinterpret_cast<const char *>(node);
+    bytes.emplace_back(p, p + n);
+  });
+  return bytes;
+}
+
+// The value of key k in ContainerType: k itself in sets, k and data
+// derived from it in maps.
+template <typename ContainerType, typename T> auto value_of(const T &k) {
+  using value_type = typename ContainerType::value_type;
+  if constexpr (std::is_same_v<value_type, T>)
+    return k;
+  else
+    return value_type(k, typename ContainerType::mapped_type(
+                             static_cast<uint64_t>(k)));
+}
+
+// Inserts and erases random keys against std::set, and every few hundred
+// writes checks each node with check_node: the search copies must be up to
+// date as soon as the writes return. Lookups through a const reference
+// must then leave every node byte untouched, as concurrent readers may run
+// them.
+template <typename SetType, typename T, typename CheckNode>
+bool check_search_copies(TestResults &results, const string &name,
+                         CheckNode check_node, int rounds = 40000) {
+  using node_type = typename SetType::wtree_type::node_type;
+  using params_type = typename SetType::wtree_type::params_type;
+  SetType storage;
+  const SetType &view = storage;
+  std::set<T> expected;
+  std::mt19937_64 rng(7);
+  const uint64_t range = rounds / 2;
+  for (int i = 1; i <= rounds; ++i) {
+    const T v = static_cast<T>(rng() % range);
+    if (rng() % 3 == 0) {
+      storage.erase(v);
+      expected.erase(v);
+    } else {
+      storage.insert(value_of<SetType>(v));
+      expected.insert(v);
+    }
+    if (i % 500 != 0)
+      continue;
+
+    bool ok = true;
+    for_each_node(storage.tree()->root(),
+                  [&](const node_type *node) { ok = ok && check_node(node); });
+    if (!ok) {
+      results.fail(name, "outdated search copy");
+      return false;
+    }
+
+    const auto before = node_bytes(*storage.tree());
+    for (int q = 0; q < 200; ++q) {
+      const T k = static_cast<T>(rng() % range);
+      const auto lb = view.lower_bound(k);
+      const auto elb = expected.lower_bound(k);
+      ok = ok && (view.find(k) != view.end()) == (expected.count(k) == 1) &&
+           view.contains(k) == (expected.count(k) == 1) &&
+           (lb == view.end() ? elb == expected.end()
+                             : elb != expected.end() &&
+                                   params_type::get_key(*lb) == *elb);
+    }
+    if (!ok) {
+      results.fail(name, "lookup");
+      return false;
+    }
+    if (node_bytes(*storage.tree()) != before) {
+      results.fail(name, "lookups wrote to the nodes");
+      return false;
+    }
+  }
+  // A leaf root would leave internal nodes unchecked.
+  if (!WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                            expected.size()) ||
+      !storage.tree()->root()->is_internal()) {
+    results.fail(name, "invalid tree");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Set params with the Eytzinger search copy enabled regardless of the
+// WTREE_EYTZINGER_INTERNAL_NODES default.
+template <typename Key, int NodeBytes>
+struct EytzingerSetParams
+    : public WTreeSetParams<Key, std::less<Key>, std::allocator<Key>,
+                            NodeBytes> {
+  static constexpr bool kUseEytzingerLayout = true;
+};
+
+template <typename Key, int NodeBytes>
+using EytzingerSet =
+    WTreeUniqueContainer<WTree<EytzingerSetParams<Key, NodeBytes>>>;
+
+// The Eytzinger copy of a full internal node, read in order (left child
+// 2i, right child 2i + 1), gives back its keys.
+template <typename Node> bool eytzinger_copy_matches(const Node *node) {
+  if (!node->is_internal() || node->size() != Node::kTargetK)
+    return true;
+  if (node->fields.layout.stale)
+    return false;
+  int next = 0;
+  bool ok = true;
+  const auto in_order = [&](auto &self, size_t i) -> void {
+    if (i > Node::kTargetK)
+      return;
+    self(self, 2 * i);
+    ok = ok && node->fields.layout.keys[i] == node->key(next++);
+    self(self, 2 * i + 1);
+  };
+  in_order(in_order, 1);
+  return ok && next == Node::kTargetK;
+}
+
+// Set params with a fence index every 16 keys.
+template <typename Key, int NodeBytes>
+struct FencedSetParams
+    : public WTreeSetParams<Key, std::less<Key>, std::allocator<Key>,
+                            NodeBytes> {
+  static constexpr uint kFenceStride = 16;
+  static constexpr bool kUseFences = true;
+};
+
+template <typename Key, int NodeBytes>
+using FencedSet = WTreeUniqueContainer<WTree<FencedSetParams<Key, NodeBytes>>>;
+
+// Fence j of a node large enough for them is its key (j + 1) * stride - 1.
+template <typename Node> bool fences_match(const Node *node) {
+  if (!node->use_fences())
+    return true;
+  if (node->fence_stale())
+    return false;
+  for (int j = 0; j < node->size() / static_cast<int>(Node::kFenceStride); ++j)
+    if (!(node->fence_keys()[j] == node->key((j + 1) * Node::kFenceStride - 1)))
+      return false;
+  return true;
+}
+
+// Set params with the learned node model enabled.
+template <typename Key, int NodeBytes>
+struct LearnedSetParams
+    : public WTreeSetParams<Key, std::less<Key>, std::allocator<Key>,
+                            NodeBytes> {
+  static constexpr bool kUseLearnedModel = true;
+};
+
+template <typename Key, int NodeBytes>
+using LearnedSet =
+    WTreeUniqueContainer<WTree<LearnedSetParams<Key, NodeBytes>>>;
+
+// The model of a node large enough for one is refit once its drift passes
+// kModelRefitDrift, and predicts the slot of every key within the window
+// searches read: max_error + drift + 1 slots.
+template <typename Node> bool model_covers_keys(const Node *node) {
+  if (!node->use_model())
+    return true;
+  const auto &m = node->model();
+  if (m.drift > Node::kModelRefitDrift)
+    return false;
+  const double window = m.max_error + m.drift + 1;
+  for (int i = 0; i < node->size(); ++i)
+    if (std::fabs(m.intercept + m.slope * static_cast<double>(node->key(i)) -
+                  i) > window)
+      return false;
+  return true;
+}
+
+// Cubic keys with a few far outliers, so that node models fit poorly and
+// searches go through wide windows and fallbacks.
+template <int NodeBytes>
+bool check_skewed_model(TestResults &results, const string &name,
+                        int count = 30000) {
+  LearnedSet<uint64_t, NodeBytes> storage;
+  std::set<uint64_t> expected;
+  std::mt19937_64 rng(3);
+  for (int i = 0; i < count; ++i) {
+    const uint64_t v = rng() % 100 == 0 ? rng() : (rng() % 100000) *
+                                                      (rng() % 100000) *
+                                                      (rng() % 1000);
+    storage.insert(v);
+    expected.insert(v);
+  }
+  for (const uint64_t v : expected) {
+    if (storage.find(v) == storage.end()) {
+      results.fail(name, "missing key");
+      return false;
+    }
+    auto lb = storage.lower_bound(v + 1);
+    auto elb = expected.lower_bound(v + 1);
+    if ((lb == storage.end()) != (elb == expected.end()) ||
+        (elb != expected.end() && *lb != *elb)) {
+      results.fail(name, "lower bound");
+      return false;
+    }
+  }
+  results.pass(name);
+  return true;
+}
+
+// contains() and count() descend without a path and stop at the first
+// exact match or at a key outside a node: every key of every node,
+// internal ones included, is found, and keys between, below and above
+// them are not. Ordered keys make deep trees.
+template <typename SetType, typename MakeKey>
+bool check_contains(TestResults &results, const string &name, bool ordered,
+                    MakeKey make_key) {
+  using node_type = typename SetType::wtree_type::node_type;
+  SetType storage;
+  const SetType &view = storage;
+  std::mt19937_64 rng(53);
+  uint64_t last = 0;
+  for (uint64_t i = 0; i < 20000; ++i) {
+    const uint64_t v = ordered ? i : rng() % 100000;
+    storage.insert(make_key(2 * v + 1));
+    last = std::max(last, v);
+  }
+
+  bool ok = storage.tree()->root()->is_internal();
+  for_each_node(storage.tree()->root(), [&](const node_type *node) {
+    for (int i = 0; i < node->size(); ++i)
+      ok = ok && view.contains(node->key(i)) && view.count(node->key(i)) == 1;
+  });
+  if (!ok) {
+    results.fail(name, "present key");
+    return false;
+  }
+  for (uint64_t v = 0; v <= last + 1; ++v)
+    if (view.contains(make_key(2 * v)) || view.count(make_key(2 * v)) != 0) {
+      results.fail(name, "absent key");
+      return false;
+    }
+  results.pass(name);
+  return true;
+}
+
+// Params that turn the column on in a derived struct are sized for it.
+using KeyColumnNode =
+    KeyColumnMap<uint64_t, uint64_t, 1024>::wtree_type::node_type;
+static_assert(KeyColumnNode::kUseKeyColumn);
+static_assert(KeyColumnNode::kTargetK <
+              WTreeLib::map<uint64_t, uint64_t, 1024>::wtree_type::node_type::
+                  kTargetK);
+static_assert(KeyColumnNode::leaf_bytes(KeyColumnNode::kTargetK) <= 1024);
+
+// Slot i of the key column of a node holds the key of its value i, whose
+// data must still be the one derived from that key.
+template <typename Node> bool key_column_matches(const Node *node) {
+  for (int i = 0; i < node->size(); ++i) {
+    const auto &v = node->value(i);
+    using Data = std::remove_cvref_t<decltype(v.second)>;
+    if (!(v.second == Data(static_cast<uint64_t>(v.first))))
+      return false;
+    if constexpr (Node::kUseKeyColumn)
+      if (!(node->key_column()[i] == v.first))
+        return false;
+  }
+  return true;
+}
+
+int main() {
+  TestResults results;
+
+  TestPrinting::job_title("Eytzinger internal nodes.");
+  const auto eytzinger = [](const auto *node) {
+    return eytzinger_copy_matches(node);
+  };
+  check_search_copies<EytzingerSet<int, 256>, int>(
+      results, "eytzinger set<int, 256>", eytzinger);
+  check_search_copies<EytzingerSet<int, 4096>, int>(
+      results, "eytzinger set<int, 4096>", eytzinger);
+  check_search_copies<EytzingerSet<uint64_t, 2048>, uint64_t>(
+      results, "eytzinger set<uint64_t, 2048>", eytzinger);
+  check_search_copies<EytzingerSet<double, 1024>, double>(
+      results, "eytzinger set<double, 1024>", eytzinger);
+
+  TestPrinting::job_title("Fence index.");
+  const auto fences = [](const auto *node) { return fences_match(node); };
+  check_search_copies<FencedSet<int, 1024>, int>(
+      results, "fenced set<int, 1024>", fences);
+  check_search_copies<FencedSet<int, 16384>, int>(
+      results, "fenced set<int, 16384>", fences);
+  check_search_copies<FencedSet<uint64_t, 4096>, uint64_t>(
+      results, "fenced set<uint64_t, 4096>", fences);
+  check_search_copies<FencedSet<float, 2048>, float>(
+      results, "fenced set<float, 2048>", fences);
+
+  TestPrinting::job_title("Learned node models.");
+  const auto model = [](const auto *node) { return model_covers_keys(node); };
+  check_search_copies<LearnedSet<int, 1024>, int>(
+      results, "learned set<int, 1024>", model);
+  check_search_copies<LearnedSet<int, 16384>, int>(
+      results, "learned set<int, 16384>", model);
+  check_search_copies<LearnedSet<uint64_t, 4096>, uint64_t>(
+      results, "learned set<uint64_t, 4096>", model);
+  check_search_copies<LearnedSet<double, 2048>, double>(
+      results, "learned set<double, 2048>", model);
+  check_skewed_model<4096>(results, "skewed learned set<uint64_t, 4096>");
+
+  TestPrinting::job_title("Map key columns.");
+  const auto column = [](const auto *node) {
+    return key_column_matches(node);
+  };
+  check_search_copies<KeyColumnMap<uint32_t, WidePayload, 4096>, uint32_t>(
+      results, "key column map<uint32_t, wide, 4096>", column);
+  check_search_copies<KeyColumnMap<uint64_t, WidePayload, 16384>, uint64_t>(
+      results, "key column map<uint64_t, wide, 16384>", column);
+  check_search_copies<KeyColumnMap<double, WidePayload, 1024>, double>(
+      results, "key column map<double, wide, 1024>", column);
+  check_search_copies<WTreeLib::map<uint32_t, WidePayload, 4096>, uint32_t>(
+      results, "map<uint32_t, wide, 4096>", column);
+
+  TestPrinting::job_title("Membership.");
+  const auto number = [](uint64_t v) { return v; };
+  check_contains<WTreeLib::set<uint64_t, 128>>(
+      results, "ordered set<uint64_t, 128>", true, number);
+  check_contains<WTreeLib::set<uint64_t, 4096>>(
+      results, "set<uint64_t, 4096>", false, number);
+  check_contains<WTreeLib::set<int, 1024, std::compare_three_way>>(
+      results, "set<int, 1024, compare_three_way>", false,
+      [](uint64_t v) { return static_cast<int>(v); });
+  check_contains<WTreeLib::set<string, 1024, std::less<>>>(
+      results, "set<string, 1024, less<>>", false,
+      [](uint64_t v) { return "key/" + std::to_string(v); });
+
+  results.summary();
+  if (!results.all_passed()) {
+    TestPrinting::test_incorrect(title);
+    return EXIT_FAILURE;
+  }
+  TestPrinting::test_correct(title);
+  return 0;
+}
@@ -0,0 +1,790 @@
+#include "../shared.hpp"
+
+#include "../../include/wtree/map.hpp"
+#include "../../include/wtree/optional/utils.hpp"
+#include "../../include/wtree/set.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <set>
+#include <string>
+
+const string title = "Memory Test";
+
+using namespace std;
+using namespace WTreeLib;
+
+// Leaf size classes run from kInitialCapacity to kTargetK.
+template <typename SetType> constexpr bool kLeafClassesSpanCapacities() {
+  using manager_type = typename SetType::wtree_type::manager_type;
+  using node_type = typename SetType::wtree_type::node_type;
+  const auto &capacities = manager_type::kLeafClassCapacities;
+  return capacities.front() == node_type::kInitialCapacity &&
+         capacities.back() == node_type::kTargetK &&
+         std::is_sorted(capacities.begin(), capacities.end());
+}
+static_assert(kLeafClassesSpanCapacities<WTreeLib::set<int, 1024>>());
+static_assert(kLeafClassesSpanCapacities<WTreeLib::set<uint64_t, 16384>>());
+static_assert(kLeafClassesSpanCapacities<WTreeLib::set<string, 4096>>());
+
+// The slab state is allocated out of line with the first node, so a tree
+// is not larger than its root, size, comparator and a pool pointer.
+static_assert(sizeof(WTreeLib::set<int>) <= 5 * sizeof(void *));
+static_assert(sizeof(WTreeLib::map<uint64_t, uint64_t>) <= 5 * sizeof(void *));
+
+// pmr set params whose node slabs come from huge-page regions regardless of
+// the WTREE_NODE_HUGE_PAGES default.
+template <int NodeBytes>
+struct HugePageSetParams
+    : public WTreeSetParams<uint64_t, std::less<uint64_t>,
+                            std::pmr::polymorphic_allocator<uint64_t>,
+                            NodeBytes> {
+  static constexpr bool kUseHugePages = true;
+};
+
+template <int NodeBytes>
+using HugePageSet =
+    WTreeUniqueContainer<WTree<HugePageSetParams<NodeBytes>>>;
+
+// Sets whose slabs all come from mapped regions, none from the allocator,
+// and whose regions move with the tree and are unmapped as clear() empties
+// them.
+template <int NodeBytes>
+bool check_huge_page_set(TestResults &results, const string &name) {
+  using SetType = HugePageSet<NodeBytes>;
+  CountingResource counting;
+  {
+    SetType storage(&counting);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(23);
+    for (int i = 0; i < 300000; ++i) {
+      const uint64_t v = rng() % 500000;
+      if (i % 5 == 4) {
+        storage.erase(v);
+        expected.erase(v);
+      } else {
+        storage.insert(v);
+        expected.insert(v);
+      }
+    }
+    const auto regions = [](SetType &s) {
+      return s.tree()->manager()->node_pool().arena().regions();
+    };
+    // Without mmap every slab comes from the allocator instead. The pool
+    // state is the one allocation the allocator makes either way.
+    if (regions(storage) > 0 && counting.allocations != 1) {
+      results.fail(name, "slabs from the allocator");
+      return false;
+    }
+    const size_t mapped = regions(storage);
+    SetType moved(std::move(storage));
+    if (regions(moved) != mapped ||
+        !WTreeValidationUtils::validate_wtree(*moved.tree(),
+                                              expected.size()) ||
+        !std::equal(moved.begin(), moved.end(), expected.begin(),
+                    expected.end())) {
+      results.fail(name, "invalid tree");
+      return false;
+    }
+    moved.clear();
+    for (uint64_t v = 0; v < 1000; ++v)
+      moved.insert(v);
+    // The root's region, and maybe an empty one kept for the next slabs.
+    if (regions(moved) > 2 ||
+        !WTreeValidationUtils::validate_wtree(*moved.tree(), 1000)) {
+      results.fail(name, "clear");
+      return false;
+    }
+  }
+  if (counting.outstanding != 0) {
+    results.fail(name, "destruction");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Set params with child handles regardless of the WTREE_NODE_CHILD_HANDLES
+// default.
+template <typename Key, int NodeBytes>
+struct ChildHandleSetParams
+    : public WTreeSetParams<Key, std::less<Key>, std::allocator<Key>,
+                            NodeBytes> {
+  static constexpr bool kUseChildHandles = true;
+};
+
+template <typename Key, int NodeBytes>
+using ChildHandleSet =
+    WTreeUniqueContainer<WTree<ChildHandleSetParams<Key, NodeBytes>>>;
+
+template <typename Key, int NodeBytes>
+constexpr size_t kInternalNodeBytes =
+    sizeof(typename WTreeLib::set<Key, NodeBytes>::wtree_type::node_type::
+               internal_fields);
+template <typename Key, int NodeBytes>
+constexpr size_t kHandleInternalNodeBytes =
+    sizeof(typename ChildHandleSet<Key, NodeBytes>::wtree_type::node_type::
+               internal_fields);
+
+// Same k, half the bytes per child.
+static_assert(ChildHandleSet<uint32_t, 512>::wtree_type::node_type::kTargetK ==
+              WTreeLib::set<uint32_t, 512>::wtree_type::node_type::kTargetK);
+static_assert(kHandleInternalNodeBytes<uint32_t, 512> +
+                  (WTreeLib::set<uint32_t, 512>::wtree_type::node_type::
+                       kTargetK -
+                   1) * 4 <=
+              kInternalNodeBytes<uint32_t, 512>);
+
+// Internal nodes hold the 32-bit handle of each child, which decodes back
+// to the child from the parent's own address, so every node of a tree lies
+// in the one span. The tree holds the span bytes of its slabs, at least
+// those of its nodes, and gives them back on clear().
+template <typename Key, int NodeBytes>
+bool check_child_handles(TestResults &results, const string &name) {
+  using SetType = ChildHandleSet<Key, NodeBytes>;
+  using node_type = typename SetType::wtree_type::node_type;
+  SetType storage;
+  std::mt19937_64 rng(43);
+  for (int i = 0; i < 40000; ++i) {
+    const Key v = static_cast<Key>(rng() % 30000);
+    if (i % 3 == 2)
+      storage.erase(v);
+    else
+      storage.insert(v);
+  }
+
+  const uintptr_t span = reinterpret_cast<uintptr_t>(storage.tree()->root()) /
+                         WTreeHandleSpan::kSpanBytes;
+  size_t node_bytes = 0;
+  bool ok = storage.tree()->root()->is_internal();
+  for_each_node(storage.tree()->root(), [&](const node_type *node) {
+    ok = ok && reinterpret_cast<uintptr_t>(node) /
+                       WTreeHandleSpan::kSpanBytes ==
+                   span;
+    if (node->is_leaf()) {
+      node_bytes += node_type::leaf_bytes(node->capacity());
+      return;
+    }
+    node_bytes += sizeof(typename node_type::internal_fields);
+    for (int i = 0; i + 1 < node->size(); ++i) {
+      const auto handle = node->fields.pointers[i];
+      ok = ok && (handle == 0) == (node->child(i) == nullptr) &&
+           WTreeHandleSpan::decode(node, handle) == node->child(i) &&
+           (handle == 0 || WTreeHandleSpan::encode(node->child(i)) == handle);
+    }
+  });
+  const auto &arena = storage.tree()->manager()->node_pool().arena();
+  if (!ok || arena.bytes() < node_bytes) {
+    results.fail(name, "child handles");
+    return false;
+  }
+  storage.clear();
+  if (arena.bytes() != 0) {
+    results.fail(name, "clear");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Child-handle trees share one span: thousands of them live at once (a
+// span each would take more address space than there is), each holds the
+// span bytes of its own slabs, and the slabs of destroyed trees are reused
+// by the next ones without carving more of the span.
+template <int NodeBytes>
+bool check_shared_handle_span(TestResults &results, const string &name) {
+  using SetType = ChildHandleSet<uint32_t, NodeBytes>;
+  constexpr int kTrees = 2500;
+  constexpr uint32_t kKeys = 20;
+  const auto fill = [](std::vector<SetType> &sets) {
+    sets.resize(kTrees);
+    for (int t = 0; t < kTrees; ++t)
+      for (uint32_t v = 0; v < kKeys; ++v)
+        sets[t].insert(v * kTrees + t);
+  };
+  const auto same = [](std::vector<SetType> &sets) {
+    for (int t = 0; t < kTrees; ++t) {
+      const auto &arena = sets[t].tree()->manager()->node_pool().arena();
+      if (sets[t].size() != kKeys || arena.bytes() == 0 ||
+          !WTreeValidationUtils::validate_wtree(*sets[t].tree(), kKeys))
+        return false;
+      uint32_t v = 0;
+      for (const uint32_t x : sets[t])
+        if (x != v++ * kTrees + t)
+          return false;
+    }
+    return true;
+  };
+  std::vector<SetType> sets;
+  fill(sets);
+  if (!same(sets)) {
+    results.fail(name, "trees sharing the span");
+    return false;
+  }
+  sets.clear();
+  const size_t carved = WTreeHandleSpan::instance().carved_bytes();
+  fill(sets);
+  if (!same(sets) || WTreeHandleSpan::instance().carved_bytes() != carved) {
+    results.fail(name, "reused span");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Grows a full leaf through the manager, from kInitialCapacity to kTargetK
+// one size class at a time, filling it again after each step: each grown
+// leaf has the capacity of the next class and keeps the values and search
+// keys of the one it replaces.
+template <typename MapType, typename MakeKey>
+bool check_leaf_growth(TestResults &results, const string &name,
+                       MakeKey make_key) {
+  using manager_type = typename MapType::wtree_type::manager_type;
+  using node_type = typename MapType::wtree_type::node_type;
+  const auto &capacities = manager_type::kLeafClassCapacities;
+  MapType storage;
+  auto *manager = storage.tree()->manager();
+  node_type *leaf = manager->new_leaf_node(node_type::kInitialCapacity);
+  bool ok = true;
+  for (size_t cls = 0; ok; ++cls) {
+    const int count = leaf->capacity();
+    for (int i = leaf->size(); i < count; ++i)
+      leaf->construct_value(i, make_key(i), i);
+    leaf->fields.size = count;
+    if (count == node_type::kTargetK)
+      break;
+
+    leaf = manager->grow_leaf(leaf);
+    ok = cls + 1 < capacities.size() &&
+         leaf->capacity() == capacities[cls + 1] && leaf->size() == count;
+    for (int i = 0; ok && i < count; ++i) {
+      ok = leaf->key(i) == make_key(i) && leaf->value(i).first == make_key(i) &&
+           leaf->value(i).second == i;
+      if constexpr (node_type::kUseKeyPrefixes)
+        ok = ok && leaf->key_prefixes()[i] ==
+                       WTreeKeyPrefix<typename node_type::key_type>::get(
+                           make_key(i));
+    }
+  }
+  manager->delete_leaf_node(leaf);
+  if (!ok) {
+    results.fail(name, "grown leaf");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Nodes are carved from slabs of many nodes: a tree allocates far fewer
+// times than it has nodes. Freed nodes go to the free list of their size
+// class and are handed out again first, without allocating, and erases
+// give no slab back.
+template <int NodeBytes>
+bool check_slab_reuse(TestResults &results, const string &name) {
+  using SetType = WTreeLib::pmr::set<uint64_t, NodeBytes>;
+  using node_type = typename SetType::wtree_type::node_type;
+  CountingResource counting;
+  SetType storage(&counting);
+  std::mt19937_64 rng(41);
+  for (int i = 0; i < 40000; ++i)
+    storage.insert(rng() % 1000000);
+  size_t nodes = 0;
+  for_each_node(storage.tree()->root(),
+                [&nodes](const node_type *) { ++nodes; });
+  if (counting.allocations * 16 > nodes) {
+    results.fail(name, "one allocation per few nodes");
+    return false;
+  }
+
+  auto *manager = storage.tree()->manager();
+  node_type *leaf = manager->new_leaf_node(node_type::kInitialCapacity);
+  node_type *internal = manager->new_internal_node();
+  const node_type *freed_leaf = leaf;
+  const node_type *freed_internal = internal;
+  const size_t allocations = counting.allocations;
+  manager->delete_leaf_node(leaf);
+  manager->delete_internal_node(internal);
+  leaf = manager->new_leaf_node(node_type::kInitialCapacity);
+  internal = manager->new_internal_node();
+  const bool reused = leaf == freed_leaf && internal == freed_internal &&
+                      counting.allocations == allocations;
+  manager->delete_leaf_node(leaf);
+  manager->delete_internal_node(internal);
+  if (!reused) {
+    results.fail(name, "freed nodes handed out again");
+    return false;
+  }
+
+  const size_t outstanding = counting.outstanding;
+  for (uint64_t v = 0; v < 1000000; ++v)
+    if (v % 8 != 0)
+      storage.erase(v);
+  if (counting.outstanding < outstanding) {
+    results.fail(name, "slabs kept through erases");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Moves nodes between the slabs of several trees: copies, swaps and moves
+// of the trees, and a refill after clearing them.
+template <typename SetType, typename T>
+bool check_slab_moves(TestResults &results, const string &name) {
+  SetType a, b;
+  std::set<T> expected_a, expected_b;
+  std::mt19937_64 rng(11);
+  for (int i = 0; i < 20000; ++i) {
+    const T v = static_cast<T>(rng() % 50000);
+    a.insert(v);
+    expected_a.insert(v);
+    if (i % 3 == 0) {
+      b.insert(v);
+      expected_b.insert(v);
+    }
+  }
+  SetType copy(a);
+  a.swap(b);
+  SetType moved(std::move(copy));
+  b.clear();
+  for (int i = 0; i < 5000; ++i)
+    b.insert(static_cast<T>(i));
+  for (int i = 0; i < 5000; i += 2)
+    b.erase(static_cast<T>(i));
+
+  std::set<T> expected_cleared;
+  for (int i = 1; i < 5000; i += 2)
+    expected_cleared.insert(static_cast<T>(i));
+  const auto same = [](SetType &storage, const std::set<T> &expected) {
+    return WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                                expected.size()) &&
+           std::equal(storage.begin(), storage.end(), expected.begin(),
+                      expected.end());
+  };
+  if (!same(a, expected_b) || !same(moved, expected_a) ||
+      !same(b, expected_cleared)) {
+    results.fail(name, "invalid tree");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// pmr sets over a monotonic arena, and over a resource that checks that
+// clear() and destruction give every slab back without visiting nodes.
+template <int NodeBytes>
+bool check_pmr_set(TestResults &results, const string &name) {
+  using SetType = WTreeLib::pmr::set<uint64_t, NodeBytes>;
+  static_assert(SetType::wtree_type::manager_type::kDeleteInBulk);
+
+  std::pmr::monotonic_buffer_resource arena;
+  std::set<uint64_t> expected;
+  {
+    SetType storage(&arena);
+    std::mt19937_64 rng(17);
+    for (int i = 0; i < 40000; ++i) {
+      const uint64_t v = rng() % 30000;
+      if (i % 4 == 3) {
+        storage.erase(v);
+        expected.erase(v);
+      } else {
+        storage.insert(v);
+        expected.insert(v);
+      }
+    }
+    if (!WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                              expected.size()) ||
+        !std::equal(storage.begin(), storage.end(), expected.begin(),
+                    expected.end())) {
+      results.fail(name, "arena tree");
+      return false;
+    }
+  }
+
+  CountingResource counting;
+  {
+    SetType storage(&counting);
+    for (uint64_t v = 0; v < 50000; ++v)
+      storage.insert(v * 7);
+    storage.clear();
+    // The slab state goes with the slabs: an empty tree holds nothing.
+    if (counting.outstanding != 0 || storage.size() != 0 ||
+        storage.begin() != storage.end()) {
+      results.fail(name, "clear");
+      return false;
+    }
+    for (uint64_t v = 0; v < 5000; ++v)
+      storage.insert(v);
+    if (!WTreeValidationUtils::validate_wtree(*storage.tree(), 5000)) {
+      results.fail(name, "refill");
+      return false;
+    }
+  }
+  if (counting.outstanding != 0) {
+    results.fail(name, "destruction");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// shrink_to_fit() after erasing most keys gives memory back, and the tree
+// keeps working (and can be compacted again) afterwards.
+template <int NodeBytes>
+bool check_shrink_set(TestResults &results, const string &name) {
+  using SetType = WTreeLib::pmr::set<uint64_t, NodeBytes>;
+  CountingResource counting;
+  {
+    SetType storage(&counting);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(29);
+    for (int i = 0; i < 60000; ++i) {
+      const uint64_t v = rng() % 1000000;
+      storage.insert(v);
+      expected.insert(v);
+    }
+    for (auto it = expected.begin(); it != expected.end();) {
+      if (*it % 3 != 0) {
+        storage.erase(*it);
+        it = expected.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    const size_t churned_bytes = counting.outstanding;
+    storage.shrink_to_fit();
+    const auto same = [&] {
+      return WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                                  expected.size()) &&
+             std::equal(storage.begin(), storage.end(), expected.begin(),
+                        expected.end());
+    };
+    if (!same() || counting.outstanding >= churned_bytes) {
+      results.fail(name, "compacted tree");
+      return false;
+    }
+    for (int i = 0; i < 20000; ++i) {
+      const uint64_t v = rng() % 1000000;
+      if (i % 2 == 0) {
+        storage.insert(v);
+        expected.insert(v);
+      } else {
+        storage.erase(v);
+        expected.erase(v);
+      }
+    }
+    storage.shrink_to_fit();
+    if (!same()) {
+      results.fail(name, "compacted twice");
+      return false;
+    }
+  }
+  if (counting.outstanding != 0) {
+    results.fail(name, "destruction");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Same for maps, whose values move to the new nodes.
+template <typename MapType, typename MakeKey>
+bool check_shrink_map(TestResults &results, const string &name,
+                      MakeKey make_key) {
+  using Key = typename MapType::key_type;
+  MapType storage;
+  std::map<Key, int> expected;
+  std::mt19937_64 rng(31);
+  for (int i = 0; i < 30000; ++i) {
+    const int v = static_cast<int>(rng() % 100000);
+    storage.insert({make_key(v), v});
+    expected.insert({make_key(v), v});
+  }
+  for (int v = 0; v < 100000; ++v) {
+    if (v % 4 != 0) {
+      storage.erase(make_key(v));
+      expected.erase(make_key(v));
+    }
+  }
+  const auto same = [&] {
+    return WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                                expected.size()) &&
+           std::equal(storage.begin(), storage.end(), expected.begin(),
+                      expected.end(), [](const auto &a, const auto &b) {
+                        return a.first == b.first && a.second == b.second;
+                      });
+  };
+  storage.shrink_to_fit();
+  if (!same()) {
+    results.fail(name, "compacted tree");
+    return false;
+  }
+  for (int i = 0; i < 10000; ++i) {
+    const int v = static_cast<int>(rng() % 100000);
+    storage.insert({make_key(v), v});
+    expected.insert({make_key(v), v});
+  }
+  storage.shrink_to_fit();
+  if (!same()) {
+    results.fail(name, "compacted twice");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Empty sets, moved-from ones included, own no node. The root is a leaf
+// that grows with the first values and becomes internal once full, and
+// clear() or shrink_to_fit() after erasing every value give it back.
+template <int NodeBytes>
+bool check_small_set(TestResults &results, const string &name) {
+  using SetType = WTreeLib::pmr::set<uint64_t, NodeBytes>;
+  using node_type = typename SetType::wtree_type::node_type;
+  constexpr int kTargetK = node_type::kTargetK;
+  CountingResource counting;
+  {
+    std::vector<SetType> empties;
+    for (int i = 0; i < 1000; ++i)
+      empties.emplace_back(&counting);
+    const SetType copy(empties.front());
+    if (counting.outstanding != 0 || copy.size() != 0 ||
+        empties.back().begin() != empties.back().end() ||
+        empties.back().count(7) != 0 || empties.back().erase(7) != 0) {
+      results.fail(name, "empty sets");
+      return false;
+    }
+
+    SetType storage(&counting);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(37);
+    while (static_cast<int>(expected.size()) <= kTargetK) {
+      const uint64_t v = rng() % 100000;
+      storage.insert(v);
+      expected.insert(v);
+      const node_type *root = storage.tree()->croot();
+      if (root->is_internal() !=
+              (static_cast<int>(expected.size()) > kTargetK) ||
+          !WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                                expected.size()) ||
+          !std::equal(storage.begin(), storage.end(), expected.begin(),
+                      expected.end())) {
+        results.fail(name, "growing root");
+        return false;
+      }
+    }
+
+    SetType moved(std::move(storage));
+    storage.insert(1);
+    if (moved.size() != expected.size() || storage.size() != 1 ||
+        *storage.begin() != 1) {
+      results.fail(name, "moved-from set");
+      return false;
+    }
+    storage.clear();
+    for (uint64_t v : expected)
+      moved.erase(v);
+    moved.shrink_to_fit();
+    if (counting.outstanding != 0 || moved.begin() != moved.end()) {
+      results.fail(name, "emptied sets");
+      return false;
+    }
+  }
+  results.pass(name);
+  return true;
+}
+
+static_assert(
+    WTreeLib::map<uint32_t, LargePayload, 4096>::wtree_type::params_type::
+        kUseOutOfLineValues);
+static_assert(!WTreeLib::map<uint32_t, WidePayload, 4096>::wtree_type::
+                  params_type::kUseOutOfLineValues);
+static_assert(!WTreeLib::map<string, LargePayload, 4096>::wtree_type::
+                  params_type::kUseOutOfLineValues);
+
+// Out-of-line values stay where they were allocated while the nodes that
+// hold their handles split, merge and slide: after churning other keys,
+// each value is at the address it was inserted at, with its own data.
+// Copies clone the values, which outlive the original being cleared.
+template <typename Key, int NodeBytes>
+bool check_out_of_line_values(TestResults &results, const string &name) {
+  using MapType = WTreeLib::map<Key, LargePayload, NodeBytes>;
+  using node_type = typename MapType::wtree_type::node_type;
+  static_assert(node_type::kUseOutOfLineValues);
+  static_assert(sizeof(typename node_type::slot_type) == sizeof(void *));
+
+  MapType storage;
+  std::map<Key, const LargePayload *> addresses;
+  std::mt19937_64 rng(37);
+  for (int i = 0; i < 60000; ++i) {
+    const Key k = static_cast<Key>(rng() % 30000);
+    if (i >= 20000 && i % 2 == 0) {
+      storage.erase(k);
+      addresses.erase(k);
+      continue;
+    }
+    auto [it, inserted] =
+        storage.insert({k, LargePayload(static_cast<uint64_t>(k))});
+    if (inserted)
+      addresses.emplace(k, &it->second);
+  }
+  const auto same = [&addresses](MapType &m, bool at_addresses) {
+    if (!WTreeValidationUtils::validate_wtree(*m.tree(), addresses.size()))
+      return false;
+    for (const auto &[k, address] : addresses) {
+      auto it = m.find(k);
+      if (it == m.end() ||
+          !(it->second == LargePayload(static_cast<uint64_t>(k))) ||
+          (&it->second == address) != at_addresses)
+        return false;
+    }
+    return true;
+  };
+  if (!same(storage, true)) {
+    results.fail(name, "moved value");
+    return false;
+  }
+
+  MapType copy(storage);
+  if (!same(copy, false)) {
+    results.fail(name, "copy");
+    return false;
+  }
+  storage.clear();
+  storage.insert({Key(1), LargePayload(1)});
+  for (const auto &[k, address] : copy)
+    if (!(address == LargePayload(static_cast<uint64_t>(k)))) {
+      results.fail(name, "copy after clear");
+      return false;
+    }
+  results.pass(name);
+  return true;
+}
+
+// pmr maps with out-of-line values: the values come from the map's
+// resource, not the default one, also in copies and after moves and swaps.
+bool check_pmr_out_of_line_map(TestResults &results, const string &name) {
+  using MapType = WTreeLib::pmr::map<uint64_t, LargePayload, 4096>;
+  static_assert(MapType::wtree_type::params_type::kUseOutOfLineValues);
+
+  CountingResource counting;
+  CountingResource fallback;
+  std::pmr::memory_resource *previous =
+      std::pmr::set_default_resource(&fallback);
+  bool ok = true;
+  {
+    MapType storage(&counting);
+    std::map<uint64_t, uint64_t> expected;
+    std::mt19937_64 rng(23);
+    for (int i = 0; i < 6000; ++i) {
+      const uint64_t k = rng() % 4000;
+      if (i % 3 == 2) {
+        storage.erase(k);
+        expected.erase(k);
+      } else if (storage.insert({k, LargePayload(k)}).second) {
+        expected.emplace(k, k);
+      }
+    }
+    const auto matches = [&expected](const MapType &m) {
+      return m.size() == expected.size() &&
+             std::equal(m.begin(), m.end(), expected.begin(), expected.end(),
+                        [](const auto &a, const auto &b) {
+                          return a.first == b.first &&
+                                 a.second == LargePayload(b.second);
+                        });
+    };
+    ok &= matches(storage);
+
+    MapType copy(storage);
+    MapType moved(std::move(copy));
+    MapType other(&counting);
+    other.insert({1, LargePayload(1)});
+    other.swap(moved);
+    ok &= matches(other) && moved.size() == 1;
+    moved.clear();
+    ok &= fallback.allocations == 0;
+  }
+  std::pmr::set_default_resource(previous);
+  ok &= counting.outstanding == 0 && fallback.allocations == 0;
+
+  if (!ok) {
+    results.fail(name, "values outside the map's resource");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+int main() {
+  TestResults results;
+
+  TestPrinting::job_title("Node slabs.");
+  check_slab_reuse<256>(results, "pmr::set<uint64_t, 256>");
+  check_slab_reuse<512>(results, "pmr::set<uint64_t, 512>");
+  check_slab_moves<WTreeLib::set<int, 256>, int>(results, "set<int, 256>");
+  check_slab_moves<WTreeLib::set<uint64_t, 4096>, uint64_t>(
+      results, "set<uint64_t, 4096>");
+  check_slab_moves<WTreeLib::set<uint32_t, 16384>, uint32_t>(
+      results, "set<uint32_t, 16384>");
+
+  TestPrinting::job_title("Arena-backed sets.");
+  check_pmr_set<512>(results, "pmr::set<uint64_t, 512>");
+  check_pmr_set<4096>(results, "pmr::set<uint64_t, 4096>");
+
+  TestPrinting::job_title("Huge-page node slabs.");
+  check_huge_page_set<512>(results, "huge page set<uint64_t, 512>");
+  check_huge_page_set<4096>(results, "huge page set<uint64_t, 4096>");
+
+  TestPrinting::job_title("Child handles.");
+  check_child_handles<uint32_t, 512>(results,
+                                     "child handle set<uint32_t, 512>");
+  check_child_handles<uint64_t, 4096>(results,
+                                      "child handle set<uint64_t, 4096>");
+  check_slab_moves<ChildHandleSet<uint32_t, 512>, uint32_t>(
+      results, "moves child handle set<uint32_t, 512>");
+  check_shared_handle_span<512>(results, "shared span set<uint32_t, 512>");
+
+  TestPrinting::job_title("Leaf growth.");
+  check_leaf_growth<WTreeLib::map<int, int, 512>>(
+      results, "map<int, int, 512>", [](int v) { return v; });
+  check_leaf_growth<KeyColumnMap<uint64_t, int, 4096>>(
+      results, "key column map<uint64_t, int, 4096>",
+      [](int v) { return static_cast<uint64_t>(v); });
+  check_leaf_growth<WTreeLib::map<string, int, 1024>>(
+      results, "map<string, int, 1024>",
+      [](int v) { return "key/" + std::to_string(v); });
+
+  TestPrinting::job_title("Shrink to fit.");
+  check_shrink_set<512>(results, "pmr::set<uint64_t, 512>");
+  check_shrink_set<4096>(results, "pmr::set<uint64_t, 4096>");
+  check_shrink_map<WTreeLib::map<string, int, 1024>>(
+      results, "map<string, int, 1024>",
+      [](int v) { return "key/" + std::to_string(v); });
+  check_shrink_map<KeyColumnMap<uint64_t, int, 4096>>(
+      results, "key column map<uint64_t, int, 4096>",
+      [](int v) { return static_cast<uint64_t>(v); });
+
+  TestPrinting::job_title("Small containers.");
+  check_small_set<512>(results, "pmr::set<uint64_t, 512>");
+  check_small_set<4096>(results, "pmr::set<uint64_t, 4096>");
+
+  TestPrinting::job_title("Out-of-line mapped values.");
+  check_out_of_line_values<uint32_t, 1024>(results,
+                                           "map<uint32_t, large, 1024>");
+  check_out_of_line_values<uint64_t, 4096>(results,
+                                           "map<uint64_t, large, 4096>");
+  check_out_of_line_values<double, 16384>(results,
+                                          "map<double, large, 16384>");
+  check_pmr_out_of_line_map(results, "pmr::map<uint64_t, large, 4096>");
+
+  results.summary();
+  if (!results.all_passed()) {
+    TestPrinting::test_incorrect(title);
+    return EXIT_FAILURE;
+  }
+  TestPrinting::test_correct(title);
+  return 0;
+}
@@ -0,0 +1,461 @@
+#include "../shared.hpp"
+
+#include "../../include/wtree/map.hpp"
+#include "../../include/wtree/optional/calibrate.hpp"
+#include "../../include/wtree/optional/utils.hpp"
+#include "../../include/wtree/set.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+const string title = "Search Test";
+
+using namespace std;
+using namespace WTreeLib;
+
+// Compares a node search kernel against std::lower_bound / std::upper_bound
+// on sorted random arrays of every size up to max_size.
+template <typename T>
+bool check_simd_kernel(TestResults &results, const string &name,
+                       int max_size = 80) {
+  std::mt19937_64 rng(1234);
+  for (int n = 0; n <= max_size; ++n) {
+    vector<T> keys(n);
+    for (T &k : keys)
+      k = static_cast<T>(rng() % 1000);
+    std::sort(keys.begin(), keys.end());
+
+    for (int probe = -1; probe <= 1001; probe += 7) {
+      const T q = static_cast<T>(probe < 0 ? 0 : probe);
+      const int lb = std::lower_bound(keys.begin(), keys.end(), q) -
+                     keys.begin();
+      const int ub = std::upper_bound(keys.begin(), keys.end(), q) -
+                     keys.begin();
+      if (WTreeSimdSearch<T>::lower_bound(keys.data(), 0, n, q) != lb ||
+          WTreeSimdSearch<T>::upper_bound(keys.data(), 0, n, q) != ub) {
+        results.fail(name, "n = " + std::to_string(n));
+        return false;
+      }
+    }
+  }
+  results.pass(name);
+  return true;
+}
+
+// Inserts random keys into a large-node set and looks all of them up,
+// along with the lower bound of absent keys.
+template <typename T, int NodeBytes, typename Policy = WTreeSearchPolicy<>>
+bool check_set_lookups(TestResults &results, const string &name,
+                       int count = 20000) {
+  using WSet = WTreeLib::set<T, NodeBytes, std::less<T>, std::allocator<T>,
+                             Policy>;
+  WSet storage;
+  std::mt19937_64 rng(42);
+  vector<T> inserted;
+  for (int i = 0; i < count; ++i) {
+    // Even keys only, so that odd keys are known to be absent.
+    const T v = static_cast<T>((rng() % (count * 8)) * 2);
+    if (storage.insert(v).second)
+      inserted.push_back(v);
+  }
+  if (!WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                            inserted.size())) {
+    results.fail(name, "invalid tree");
+    return false;
+  }
+
+  for (const T &v : inserted) {
+    if (storage.find(v) == storage.end() || storage.count(v) != 1) {
+      results.fail(name, "missing key");
+      return false;
+    }
+  }
+
+  std::sort(inserted.begin(), inserted.end());
+  for (size_t i = 0; i + 1 < inserted.size(); i += 13) {
+    const T absent = inserted[i] + 1;
+    auto it = storage.lower_bound(absent);
+    if (it == storage.end() || *it != inserted[i + 1] ||
+        storage.count(absent) != 0) {
+      results.fail(name, "wrong lower bound");
+      return false;
+    }
+  }
+  results.pass(name);
+  return true;
+}
+
+// Checks every forced search method of the node search API against
+// std::lower_bound / std::upper_bound on the keys of each node of a tree.
+template <WTreeSearchMethod Method, typename Node, typename Compare>
+bool check_node_methods(const Node *node, const Compare &comp) {
+  using key_type = typename Node::key_type;
+  if (node == nullptr)
+    return true;
+  vector<key_type> keys(node->size());
+  for (int i = 0; i < node->size(); ++i)
+    keys[i] = node->key(i);
+
+  for (int i = 0; i <= node->size() * 2; ++i) {
+    // Probes at every key (even i) and between keys (odd i).
+    const key_type q = keys.empty() ? key_type(0)
+                       : i % 2 == 0 && i / 2 < node->size()
+                           ? keys[i / 2]
+                           : keys[std::min<int>(i / 2, node->size() - 1)] + 1;
+    const int lb = std::lower_bound(keys.begin(), keys.end(), q) - keys.begin();
+    const int ub = std::upper_bound(keys.begin(), keys.end(), q) - keys.begin();
+    const int mask = Node::kMatchMask;
+
+    if (node->is_leaf()) {
+      if ((node->template lower_bound_leaf<Method>(q, comp) & mask) != lb ||
+          (node->template upper_bound_leaf<Method>(q, comp) & mask) != ub)
+        return false;
+      if (!keys.empty() && q <= keys.back() &&
+          (node->template bounded_lower_bound_leaf<Method>(q, comp) & mask) !=
+              lb)
+        return false;
+    } else {
+      if ((node->template lower_bound_internal<Method>(q, comp) & mask) !=
+              lb ||
+          (node->template upper_bound_internal<Method>(q, comp) & mask) != ub)
+        return false;
+      if (q <= keys.back() &&
+          (node->template bounded_lower_bound_internal<Method>(q, comp) &
+           mask) != lb)
+        return false;
+    }
+  }
+
+  if (node->is_internal())
+    for (int i = 0; i < Node::kTargetK - 1; ++i)
+      if (!check_node_methods<Method>(node->child(i), comp))
+        return false;
+  return true;
+}
+
+template <typename T, int NodeBytes>
+bool check_search_methods(TestResults &results, const string &name) {
+  WTreeLib::set<T, NodeBytes> storage;
+  std::mt19937_64 rng(99);
+  for (int i = 0; i < 20000; ++i)
+    storage.insert(static_cast<T>((rng() % 100000) * 2));
+  const auto *root = storage.tree()->root();
+  const auto compare_to = storage.tree()->key_comp();
+  const std::less<T> less;
+
+  using M = WTreeSearchMethod;
+  if (!check_node_methods<M::kLinear>(root, less) ||
+      !check_node_methods<M::kSimd>(root, less) ||
+      !check_node_methods<M::kBinary>(root, less) ||
+      !check_node_methods<M::kBranchless>(root, less) ||
+      !check_node_methods<M::kInterpolation>(root, less) ||
+      !check_node_methods<M::kLinear>(root, compare_to) ||
+      !check_node_methods<M::kSimd>(root, compare_to) ||
+      !check_node_methods<M::kBinary>(root, compare_to) ||
+      !check_node_methods<M::kBranchless>(root, compare_to) ||
+      !check_node_methods<M::kInterpolation>(root, compare_to)) {
+    results.fail(name, "wrong bound");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Branch-free search in internal nodes, and a user-provided kernel in
+// leaves: a galloping search from the front of the range.
+struct GallopingLeafPolicy
+    : WTreeSearchPolicy<WTreeSearchMethod::kBranchless,
+                        WTreeSearchMethod::kCustom> {
+  template <typename Node, typename Compare>
+  static int lower_bound(const Node &node, const typename Node::key_type &k,
+                         int s, int e, const Compare &comp) {
+    auto left_of = [&](int i) {
+      if constexpr (std::is_same_v<decltype(comp(node.key(i), k)), int>)
+        return comp(node.key(i), k) < 0;
+      else
+        return static_cast<bool>(comp(node.key(i), k));
+    };
+    // Every slot before lo is left of k; hi is e or not left of k.
+    int lo = s, hi = s;
+    for (int step = 1; hi < e && left_of(hi); step <<= 1) {
+      lo = hi + 1;
+      hi += step;
+    }
+    hi = std::min(hi, e);
+    while (lo < hi) {
+      const int mid = lo + (hi - lo) / 2;
+      if (left_of(mid))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+};
+
+// Set params whose nodes read the search threshold at runtime.
+template <typename Key, int NodeBytes>
+struct CalibratedSetParams
+    : public WTreeSetParams<Key, std::less<Key>, std::allocator<Key>,
+                            NodeBytes> {
+  static constexpr bool kUseCalibratedThreshold = true;
+};
+
+template <typename Key, int NodeBytes>
+using CalibratedSet =
+    WTreeUniqueContainer<WTree<CalibratedSetParams<Key, NodeBytes>>>;
+
+// Mixes inserts, erases and lookups, comparing against std::set.
+template <typename SetType, typename T>
+bool check_mixed_workload(TestResults &results, const string &name,
+                          int rounds = 60000) {
+  SetType storage;
+  std::set<T> expected;
+  std::mt19937_64 rng(7);
+  const uint64_t range = rounds / 2;
+  for (int i = 0; i < rounds; ++i) {
+    const T v = static_cast<T>(rng() % range);
+    if (rng() % 3 == 0) {
+      auto it = storage.find(v);
+      if ((it != storage.end()) != (expected.erase(v) == 1)) {
+        results.fail(name, "find before erase");
+        return false;
+      }
+      if (it != storage.end())
+        storage.erase(it);
+    } else if (storage.insert(v).second != expected.insert(v).second) {
+      results.fail(name, "insert");
+      return false;
+    }
+
+    const T q = static_cast<T>(rng() % range);
+    auto lb = storage.lower_bound(q);
+    auto elb = expected.lower_bound(q);
+    if ((lb == storage.end()) != (elb == expected.end()) ||
+        (elb != expected.end() && *lb != *elb)) {
+      results.fail(name, "lower bound");
+      return false;
+    }
+  }
+  if (!WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                            expected.size()) ||
+      !std::equal(storage.begin(), storage.end(), expected.begin(),
+                  expected.end())) {
+    results.fail(name, "invalid tree");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Calibrates set<int> over small nodes, then runs a workload with forced
+// extreme thresholds (always binary, always linear).
+bool check_calibration(TestResults &results, const string &name) {
+  using threshold = WTreeCalibratedThreshold<int, std::less<int>>;
+  std::mt19937_64 rng(5);
+  const uint measured = WTreeCalibration::calibrate<CalibratedSet<int, 1024>>(
+      [&rng](uint) { return static_cast<int>(rng()); }, 64);
+  if (measured < 4 || measured > 65 || threshold::value != measured) {
+    results.fail(name, "threshold out of range");
+    return false;
+  }
+
+  bool ok = true;
+  for (const uint forced : {1u, 100000u}) {
+    threshold::value = forced;
+    ok = ok && check_mixed_workload<CalibratedSet<int, 1024>, int>(
+                   results, name + " @" + std::to_string(forced), 20000);
+  }
+  threshold::value = WTreeSearchThreshold<int, std::less<int>>::value;
+  return ok;
+}
+
+// The abbreviated keys count against the node bytes.
+using StringNode = WTreeLib::set<string, 512>::wtree_type::node_type;
+static_assert(StringNode::kUseKeyPrefixes);
+static_assert(StringNode::leaf_bytes(StringNode::kTargetK) <= 512);
+
+// Random string keys: shared URL-like prefixes (so that abbreviated keys
+// tie often), short keys, and keys that only differ by trailing '\0'.
+string random_string_key(std::mt19937_64 &rng, uint64_t range) {
+  const uint64_t v = rng() % range;
+  switch (v % 4) {
+  case 0:
+    return "https://example.com/item/" + std::to_string(v);
+  case 1:
+    return std::to_string(v);
+  case 2:
+    return string("ab\0", 3) + string(v % 5, '\0');
+  default:
+    return string(1, static_cast<char>(v % 256)) + std::to_string(v / 7);
+  }
+}
+
+// Mixed workload over string keys, whose searches go through the
+// abbreviated keys, against std::map.
+template <int NodeBytes, typename Compare = std::less<string>>
+bool check_string_keys(TestResults &results, const string &name,
+                       int rounds = 40000) {
+  WTreeLib::map<string, int, NodeBytes, Compare> storage;
+  std::map<string, int> expected;
+  std::mt19937_64 rng(11);
+  const uint64_t range = rounds / 2;
+  for (int i = 0; i < rounds; ++i) {
+    const string k = random_string_key(rng, range);
+    if (rng() % 3 == 0) {
+      auto it = storage.find(k);
+      if ((it != storage.end()) != (expected.erase(k) == 1)) {
+        results.fail(name, "find before erase");
+        return false;
+      }
+      if (it != storage.end())
+        storage.erase(it);
+    } else if (storage.insert({k, i}).second !=
+               expected.insert({k, i}).second) {
+      results.fail(name, "insert");
+      return false;
+    }
+
+    const string q = random_string_key(rng, range);
+    auto lb = storage.lower_bound(q);
+    auto elb = expected.lower_bound(q);
+    if ((lb == storage.end()) != (elb == expected.end()) ||
+        (elb != expected.end() && *lb != *elb)) {
+      results.fail(name, "lower bound");
+      return false;
+    }
+  }
+  if (!WTreeValidationUtils::validate_wtree(*storage.tree(),
+                                            expected.size()) ||
+      !std::equal(storage.begin(), storage.end(), expected.begin(),
+                  expected.end())) {
+    results.fail(name, "invalid tree");
+    return false;
+  }
+  results.pass(name);
+  return true;
+}
+
+// Composite key ordered by its defaulted operator<=>: groups first, so that
+// comparisons often go past the first member.
+struct CompositeKey {
+  CompositeKey() = default;
+  CompositeKey(uint64_t v) : group(static_cast<uint32_t>(v % 7)), id(v) {}
+  auto operator<=>(const CompositeKey &) const = default;
+
+  uint32_t group = 0;
+  uint64_t id = 0;
+};
+
+// Class keys under std::less<> and std::compare_three_way go through the
+// compare-to path; numeric keys keep the boolean compare.
+template <typename Key, typename Compare>
+constexpr bool kThreeWayRouted =
+    WTreeLib::set<Key, 256, Compare>::wtree_type::node_type::params_type::
+        is_key_compare_to::value;
+static_assert(kThreeWayRouted<CompositeKey, std::less<>>);
+static_assert(kThreeWayRouted<CompositeKey, std::compare_three_way>);
+static_assert(kThreeWayRouted<std::string_view, std::less<>>);
+static_assert(kThreeWayRouted<string, std::less<>>);
+static_assert(!kThreeWayRouted<int, std::less<>>);
+static_assert(!kThreeWayRouted<int, std::compare_three_way>);
+static_assert(!kThreeWayRouted<CompositeKey, std::less<CompositeKey>>);
+
+// A partial order has no int for unordered keys: they keep operator<.
+struct MeasuredKey {
+  auto operator<=>(const MeasuredKey &) const = default;
+
+  double weight = 0;
+};
+static_assert(!kThreeWayRouted<MeasuredKey, std::less<>>);
+static_assert(!kThreeWayRouted<MeasuredKey, std::compare_three_way>);
+
+// The adapter takes the scan order of the comparator it replaces.
+static_assert(WTreeSimdCompareOrder<CompositeKey,
+                                    WTreeThreeWayCompareAdapter<
+                                        CompositeKey, std::less<>>>::value ==
+              WTreeSimdOrder::kLess);
+static_assert(
+    WTreeSimdCompareOrder<CompositeKey,
+                          WTreeThreeWayCompareAdapter<
+                              CompositeKey, std::compare_three_way>>::value ==
+    WTreeSimdOrder::kLess);
+
+int main() {
+  TestResults results;
+
+  TestPrinting::job_title("SIMD kernels against std::lower/upper_bound.");
+  check_simd_kernel<int32_t>(results, "int32_t kernel");
+  check_simd_kernel<uint32_t>(results, "uint32_t kernel");
+  check_simd_kernel<int64_t>(results, "int64_t kernel");
+  check_simd_kernel<uint64_t>(results, "uint64_t kernel");
+  check_simd_kernel<float>(results, "float kernel");
+  check_simd_kernel<double>(results, "double kernel");
+  check_simd_kernel<int16_t>(results, "int16_t (scalar) kernel");
+
+  TestPrinting::job_title("Large-node set lookups.");
+  check_set_lookups<int, 512>(results, "set<int, 512>");
+  check_set_lookups<int, 4096>(results, "set<int, 4096>");
+  check_set_lookups<uint64_t, 4096>(results, "set<uint64_t, 4096>");
+  check_set_lookups<double, 2048>(results, "set<double, 2048>");
+
+  TestPrinting::job_title("Interpolation search containers.");
+  using Interpolation = WTreeSearchPolicy<WTreeSearchMethod::kInterpolation>;
+  check_set_lookups<int, 512, Interpolation>(results,
+                                             "interpolation set<int, 512>");
+  check_set_lookups<uint64_t, 16384, Interpolation>(
+      results, "interpolation set<uint64_t, 16384>");
+  check_set_lookups<double, 4096, Interpolation>(
+      results, "interpolation set<double, 4096>");
+
+  TestPrinting::job_title("Search policies.");
+  using BinaryLinear =
+      WTreeSearchPolicy<WTreeSearchMethod::kBinary, WTreeSearchMethod::kLinear>;
+  check_set_lookups<int, 2048, BinaryLinear>(results,
+                                             "binary/linear set<int, 2048>");
+  check_set_lookups<uint64_t, 4096, GallopingLeafPolicy>(
+      results, "custom leaves set<uint64_t, 4096>");
+  check_mixed_workload<
+      WTreeLib::set<int, 1024, std::less<int>, std::allocator<int>,
+                    GallopingLeafPolicy>,
+      int>(results, "custom leaves set<int, 1024>");
+
+  TestPrinting::job_title("Forced node search methods.");
+  check_search_methods<int, 512>(results, "methods set<int, 512>");
+  check_search_methods<uint64_t, 4096>(results, "methods set<uint64_t, 4096>");
+  check_search_methods<double, 2048>(results, "methods set<double, 2048>");
+
+  TestPrinting::job_title("Calibrated search thresholds.");
+  check_calibration(results, "calibrated set<int, 1024>");
+
+  TestPrinting::job_title("Abbreviated string keys.");
+  check_string_keys<256>(results, "map<string, int, 256>");
+  check_string_keys<1024>(results, "map<string, int, 1024>");
+  check_string_keys<4096>(results, "map<string, int, 4096>");
+
+  TestPrinting::job_title("Three-way comparisons.");
+  check_mixed_workload<WTreeLib::set<CompositeKey, 1024, std::less<>>,
+                       CompositeKey>(results, "set<composite, 1024, less<>>");
+  check_mixed_workload<
+      WTreeLib::set<CompositeKey, 4096, std::compare_three_way>, CompositeKey>(
+      results, "set<composite, 4096, compare_three_way>");
+  check_mixed_workload<WTreeLib::set<int, 1024, std::compare_three_way>, int>(
+      results, "set<int, 1024, compare_three_way>");
+  check_string_keys<1024, std::less<>>(results,
+                                       "map<string, int, 1024, less<>>");
+
+  results.summary();
+  if (!results.all_passed()) {
+    TestPrinting::test_incorrect(title);
+    return EXIT_FAILURE;
+  }
+  TestPrinting::test_correct(title);
+  return 0;
+}
@@ -2,11 +2,14 @@
 #define _WTREE_TEST_SHARED_H_
 
 #include "../include/wtree/detail/index.hpp"
+#include "../include/wtree/map.hpp"
 
 #include "../include/wtree/optional/print.hpp"
 #include "../include/wtree/optional/utils.hpp"
 
+#include <cstddef>
 #include <iostream>
+#include <memory_resource>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -176,6 +179,53 @@ vector<T> construct_values_vector(WTreeLib::WTreeNode<Params> *node) {
   return vector<T>(begin, begin + node->size());
 }
 
+// Calls fn with node and each of its descendants.
+template <typename Node, typename Fn> void for_each_node(Node *node, Fn &&fn) {
+  if (node->size() == 0)
+    return;
+  fn(node);
+  if (node->is_internal())
+    for (int i = 0; i + 1 < node->size(); ++i)
+      if (node->child(i) != nullptr)
+        for_each_node(node->child(i), fn);
+}
+
+// Checks the child bitmap scans of node and its descendants, from every
+// index, against a scan of the children themselves.
+template <typename Params>
+bool child_scans_match(const WTreeLib::WTreeNode<Params> *node) {
+  using NodeType = WTreeLib::WTreeNode<Params>;
+  using Field = typename NodeType::field_type;
+  if (node == nullptr || node->is_leaf())
+    return true;
+  const int children = NodeType::kTargetK - 1;
+  for (int from = 0; from <= children; ++from) {
+    // The first child at or after from, else the last index.
+    int right = children;
+    for (int i = from; i < children; ++i)
+      if (node->child(i) != nullptr) {
+        right = i;
+        break;
+      }
+    // One past the last child before from, else 0.
+    int left = 0;
+    for (int i = from - 1; i >= 0; --i)
+      if (node->child(i) != nullptr) {
+        left = i + 1;
+        break;
+      }
+    if (node->first_right_descendant(static_cast<Field>(from)) != right ||
+        node->first_left_descendant(static_cast<Field>(from)) != left) {
+      cout << "Child scans from " << from << " disagree with the children\n";
+      return false;
+    }
+  }
+  for (int i = 0; i < children; ++i)
+    if (!child_scans_match(node->child(i)))
+      return false;
+  return true;
+}
+
 template <typename T> void print_vector(vector<T> &v, string title = "V: ") {
   cout << title << "\n";
   for (const T &val : v) {
@@ -184,4 +234,92 @@ template <typename T> void print_vector(vector<T> &v, string title = "V: ") {
   cout << "\n";
 }
 
+// ============================================================================
+// CountedValue — an int wrapper that counts its live copies, so tests can
+// check that the tree destroys exactly the values it drops, and only once.
+// ============================================================================
+
+struct CountedValue {
+  static inline long live = 0;
+  static inline long bad_destroys = 0;
+  static constexpr unsigned kAlive = 0xA11CEu;
+
+  int value = 0;
+  unsigned state = kAlive;
+
+  CountedValue(int v) : value(v) { ++live; }
+  CountedValue(const CountedValue &o) : value(o.value) { ++live; }
+  CountedValue(CountedValue &&o) noexcept : value(o.value) { ++live; }
+  CountedValue &operator=(const CountedValue &) = default;
+  CountedValue &operator=(CountedValue &&) = default;
+  ~CountedValue() {
+    if (state != kAlive)
+      ++bad_destroys;
+    state = 0;
+    --live;
+  }
+
+  bool operator<(const CountedValue &o) const { return value < o.value; }
+
+  static void reset() { live = bad_destroys = 0; }
+};
+
+
+// ============================================================================
+// CountingResource — counts the bytes it has handed out and not got back.
+// ============================================================================
+
+class CountingResource : public std::pmr::memory_resource {
+public:
+  size_t outstanding = 0;
+  size_t allocations = 0;
+
+private:
+  void *do_allocate(size_t bytes, size_t align) override {
+    outstanding += bytes;
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t align) override {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// ============================================================================
+// Payload — mapped data much larger than its key, derived from the key so
+// that a value separated from its key shows up.
+// ============================================================================
+
+template <int Words> struct Payload {
+  Payload() = default;
+  explicit Payload(uint64_t k) {
+    for (int i = 0; i < Words; ++i)
+      words[i] = k * 31 + i;
+  }
+  bool operator==(const Payload &) const = default;
+
+  uint64_t words[Words] = {};
+};
+
+using WidePayload = Payload<7>;
+// Past WTREE_MAP_OUT_OF_LINE_BYTES, so stored out of line.
+using LargePayload = Payload<24>;
+
+// Map params with the key column enabled regardless of the
+// WTREE_MAP_KEY_COLUMN default.
+template <typename Key, typename Data, int NodeBytes>
+struct KeyColumnMapParams
+    : public WTreeLib::WTreeMapParams<Key, Data, std::less<Key>,
+                                      std::allocator<Key>, NodeBytes> {
+  static constexpr bool kUseKeyColumn = true;
+};
+
+template <typename Key, typename Data, int NodeBytes>
+using KeyColumnMap = WTreeLib::WTreeMapContainer<
+    WTreeLib::WTree<KeyColumnMapParams<Key, Data, NodeBytes>>>;
+
 #endif